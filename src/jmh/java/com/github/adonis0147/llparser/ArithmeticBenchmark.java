@@ -0,0 +1,59 @@
+package com.github.adonis0147.llparser;
+
+import com.github.adonis0147.llparser.examples.arithmetic.ArithmeticParser;
+import com.github.adonis0147.llparser.examples.arithmetic.Token;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+// End to end parsing and evaluation of a short expression, a long flat one and a deeply parenthesized one.
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Thread)
+public class ArithmeticBenchmark {
+
+  @Param({"small", "large", "nested"})
+  public String shape;
+
+  private final ArithmeticParser parser = new ArithmeticParser();
+  private String expression;
+
+  @Setup
+  public void setUp() {
+    switch (shape) {
+      case "small":
+        expression = "1 + 2 * (3 - 4) / 5";
+        break;
+      case "large":
+        expression = "1" + Benchmarks.repeat(" + 2 * 3 - 4 / 5", 2000);
+        break;
+      case "nested":
+        expression = Benchmarks.repeat("(1 + ", 200) + "1" + Benchmarks.repeat(")", 200);
+        break;
+      default:
+        throw new IllegalArgumentException("Unknown shape: " + shape);
+    }
+  }
+
+  @Benchmark
+  public Token parse() {
+    return parser.parse(expression);
+  }
+
+  @Benchmark
+  public long evaluate() {
+    return parser.evaluate(expression);
+  }
+}
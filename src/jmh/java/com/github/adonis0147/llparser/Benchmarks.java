@@ -0,0 +1,23 @@
+package com.github.adonis0147.llparser;
+
+final class Benchmarks {
+
+  private Benchmarks() {
+  }
+
+  // A benchmark that silently measures a failing parse measures the wrong thing.
+  static Result check(Result result) {
+    if (result.status != Status.SUCCESS) {
+      throw new IllegalStateException("Parse failed at " + result.index + ", expected: " + result.expected);
+    }
+    return result;
+  }
+
+  static String repeat(String text, int count) {
+    StringBuilder builder = new StringBuilder(text.length() * count);
+    for (int i = 0; i < count; ++ i) {
+      builder.append(text);
+    }
+    return builder.toString();
+  }
+}
@@ -0,0 +1,96 @@
+package com.github.adonis0147.llparser;
+
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+// One benchmark per combinator, each driven over `count` repetitions of its smallest input.
+// Run with -prof gc to see gc.alloc.rate.norm, the bytes allocated per parse.
+@BenchmarkMode(Mode.Throughput)
+@OutputTimeUnit(TimeUnit.SECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Thread)
+public class CombinatorBenchmark {
+
+  private static final Parser STRING = LLParser.string("select").many();
+  private static final Parser REGEX = LLParser.regex("[a-z]+ ").many();
+  private static final Parser SEQUENCE = LLParser.sequence(
+      LLParser.string("a"), LLParser.string("b"), LLParser.string("c")).many();
+  private static final Parser ALTERNATIVE = LLParser.alternative(
+      LLParser.string("a"), LLParser.string("b"), LLParser.string("c"), LLParser.string("d")).many();
+  private static final Parser MANY = LLParser.character(CharClass.DIGIT).many();
+  private static final Parser SKIP_MANY = LLParser.character(CharClass.DIGIT).skipMany();
+  private static final Parser TIMES = LLParser.string("xy").atLeast(0);
+  private static final Parser COMPILED = ALTERNATIVE.compile();
+
+  @Param({"10", "10000"})
+  public int count;
+
+  private String keywords;
+  private String words;
+  private String letters;
+  private String reversedLetters;
+  private String digits;
+  private String pairs;
+
+  @Setup
+  public void setUp() {
+    keywords = Benchmarks.repeat("select", count);
+    words = Benchmarks.repeat("word ", count);
+    letters = Benchmarks.repeat("abc", count);
+    reversedLetters = Benchmarks.repeat("dcba", count);
+    digits = Benchmarks.repeat("0123456789", count);
+    pairs = Benchmarks.repeat("xy", count);
+  }
+
+  @Benchmark
+  public Result string() {
+    return Benchmarks.check(STRING.parse(keywords));
+  }
+
+  @Benchmark
+  public Result regex() {
+    return Benchmarks.check(REGEX.parse(words));
+  }
+
+  @Benchmark
+  public Result sequence() {
+    return Benchmarks.check(SEQUENCE.parse(letters));
+  }
+
+  @Benchmark
+  public Result alternative() {
+    return Benchmarks.check(ALTERNATIVE.parse(reversedLetters));
+  }
+
+  @Benchmark
+  public Result compiledAlternative() {
+    return Benchmarks.check(COMPILED.parse(reversedLetters));
+  }
+
+  @Benchmark
+  public Result many() {
+    return Benchmarks.check(MANY.parse(digits));
+  }
+
+  @Benchmark
+  public Result skipMany() {
+    return Benchmarks.check(SKIP_MANY.parse(digits));
+  }
+
+  @Benchmark
+  public Result times() {
+    return Benchmarks.check(TIMES.parse(pairs));
+  }
+}
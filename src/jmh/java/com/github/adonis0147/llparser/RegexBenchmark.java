@@ -0,0 +1,77 @@
+package com.github.adonis0147.llparser;
+
+import java.util.concurrent.TimeUnit;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+// Compares regex() with the Matcher-per-call implementation it replaced on a whitespace heavy document.
+@BenchmarkMode(Mode.AverageTime)
+@OutputTimeUnit(TimeUnit.MILLISECONDS)
+@Warmup(iterations = 5, time = 1)
+@Measurement(iterations = 5, time = 1)
+@Fork(1)
+@State(Scope.Thread)
+public class RegexBenchmark {
+
+  @Param({"1000", "200000"})
+  public int words;
+
+  private String document;
+  private Parser current;
+  private Parser legacy;
+
+  @Setup
+  public void setUp() {
+    StringBuilder builder = new StringBuilder();
+    for (int i = 0; i < words; ++ i) {
+      builder.append(i % 7 == 0 ? "\n\t" : " ").append("word").append(i);
+    }
+    document = builder.append('\n').toString();
+    current = grammar(LLParser.regex("\\w+"), LLParser.regex("\\s+"), LLParser.regex("\\s*"));
+    legacy = grammar(legacyRegex("\\w+"), legacyRegex("\\s+"), legacyRegex("\\s*"));
+  }
+
+  @Benchmark
+  public Result current() {
+    return Benchmarks.check(current.parse(document));
+  }
+
+  @Benchmark
+  public Result legacy() {
+    return Benchmarks.check(legacy.parse(document));
+  }
+
+  // OPTIONAL_WHITESPACES word (WHITESPACES word)* OPTIONAL_WHITESPACES
+  private static Parser grammar(Parser word, Parser whitespaces, Parser optionalWhitespaces) {
+    return LLParser.sequence(
+        optionalWhitespaces,
+        word,
+        whitespaces.then(word).many(),
+        optionalWhitespaces
+    );
+  }
+
+  private static Parser legacyRegex(String patternString) {
+    Pattern pattern = Pattern.compile("^(?:" + patternString + ")");
+    return new LLParser<String>((input, index) -> {
+      Matcher matcher = pattern.matcher(input);
+      matcher.region(index, input.length());
+      if (matcher.find()) {
+        return new Result<String>(Status.SUCCESS, matcher.group(), index + matcher.group(0).length());
+      } else {
+        return new Result<String>(Status.FAILURE, index, "regular expression: " + patternString);
+      }
+    });
+  }
+}
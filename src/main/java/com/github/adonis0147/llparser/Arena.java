@@ -0,0 +1,104 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+
+// A flat syntax tree: nodes are ints indexing parallel arrays of kinds, children and values, so
+// building a tree allocates nothing once the arrays have grown. Parsers built with Parser.build()
+// and IntParser.chainl(operator, combiner) add their nodes to the Arena the parse runs through.
+// reset() drops every node and keeps the arrays for the next parse. An Arena is not thread-safe.
+public final class Arena {
+
+  @FunctionalInterface
+  public interface Builder<T> {
+    // Returns the node for a parsed value.
+    int build(Arena arena, T value);
+  }
+
+  @FunctionalInterface
+  public interface Combiner<T> {
+    // Returns the node for an operator between the nodes of its operands.
+    int combine(Arena arena, int left, T operator, int right);
+  }
+
+  public static final int NONE = -1;
+
+  private static final int INITIAL_CAPACITY = 64;
+
+  private int[] kinds = new int[INITIAL_CAPACITY];
+  private int[] lefts = new int[INITIAL_CAPACITY];
+  private int[] rights = new int[INITIAL_CAPACITY];
+  private long[] values = new long[INITIAL_CAPACITY];
+  private int size;
+
+  // Parses all of the input with the nodes going to this Arena. Nodes of earlier parses are kept.
+  public <T> Result<T> parse(Parser<T> parser, CharSequence input) {
+    if (input == null) {
+      throw new IllegalArgumentException("The input text is null.");
+    }
+    Parser<T> untilEof = LLParser.untilEof(parser);
+    ParseContext context = ParseContext.open();
+    context.arena = this;
+    try {
+      return context.complete(untilEof.parse(input, 0, context));
+    } finally {
+      context.close();
+    }
+  }
+
+  public int leaf(int kind, long value) {
+    return add(kind, NONE, NONE, value);
+  }
+
+  public int node(int kind, int left, int right) {
+    return add(kind, left, right, 0);
+  }
+
+  public int add(int kind, int left, int right, long value) {
+    if (size == kinds.length) {
+      int capacity = size << 1;
+      kinds = Arrays.copyOf(kinds, capacity);
+      lefts = Arrays.copyOf(lefts, capacity);
+      rights = Arrays.copyOf(rights, capacity);
+      values = Arrays.copyOf(values, capacity);
+    }
+    kinds[size] = kind;
+    lefts[size] = left;
+    rights[size] = right;
+    values[size] = value;
+    return size ++;
+  }
+
+  public int kind(int node) {
+    checkNode(node);
+    return kinds[node];
+  }
+
+  public int left(int node) {
+    checkNode(node);
+    return lefts[node];
+  }
+
+  public int right(int node) {
+    checkNode(node);
+    return rights[node];
+  }
+
+  public long value(int node) {
+    checkNode(node);
+    return values[node];
+  }
+
+  public int size() {
+    return size;
+  }
+
+  public void reset() {
+    size = 0;
+  }
+
+  private void checkNode(int node) {
+    if (node < 0 || node >= size) {
+      throw new IndexOutOfBoundsException("node " + node + ", size " + size);
+    }
+  }
+}
@@ -0,0 +1,108 @@
+package com.github.adonis0147.llparser;
+
+import java.util.function.IntPredicate;
+
+// A set of characters with an O(1) bitmap lookup for ASCII. Anything above is delegated to a predicate.
+public final class CharClass {
+
+  private final long low;
+  private final long high;
+  private final IntPredicate other;
+  private final String description;
+
+  private CharClass(long low, long high, IntPredicate other, String description) {
+    this.low = low;
+    this.high = high;
+    this.other = other;
+    this.description = description;
+  }
+
+  public static CharClass of(String chars) {
+    if (Utils.isStringNullOrEmpty(chars)) {
+      throw new IllegalArgumentException("String is null or empty.");
+    }
+    long low = 0, high = 0;
+    StringBuilder nonAscii = new StringBuilder();
+    for (int i = 0; i < chars.length(); ++ i) {
+      char c = chars.charAt(i);
+      if (c < 64) {
+        low |= 1L << c;
+      } else if (c < 128) {
+        high |= 1L << (c - 64);
+      } else {
+        nonAscii.append(c);
+      }
+    }
+    String others = nonAscii.toString();
+    IntPredicate other = others.isEmpty() ? null : c -> others.indexOf(c) >= 0;
+    return new CharClass(low, high, other, "one of \"" + chars + "\"");
+  }
+
+  public static CharClass range(char from, char to) {
+    if (to < from) {
+      throw new IllegalArgumentException("To is less than from.");
+    }
+    long low = 0, high = 0;
+    for (int c = from; c <= to && c < 128; ++ c) {
+      if (c < 64) {
+        low |= 1L << c;
+      } else {
+        high |= 1L << (c - 64);
+      }
+    }
+    IntPredicate other = to < 128 ? null : c -> c >= from && c <= to;
+    return new CharClass(low, high, other, "'" + from + "'-'" + to + "'");
+  }
+
+  public static CharClass matching(IntPredicate predicate, String description) {
+    long low = 0, high = 0;
+    for (int c = 0; c < 128; ++ c) {
+      if (!predicate.test(c)) {
+        continue;
+      }
+      if (c < 64) {
+        low |= 1L << c;
+      } else {
+        high |= 1L << (c - 64);
+      }
+    }
+    return new CharClass(low, high, predicate, description);
+  }
+
+  public CharClass or(CharClass charClass) {
+    IntPredicate other;
+    if (this.other == null) {
+      other = charClass.other;
+    } else if (charClass.other == null) {
+      other = this.other;
+    } else {
+      other = this.other.or(charClass.other);
+    }
+    return new CharClass(low | charClass.low, high | charClass.high, other,
+        description + " or " + charClass.description);
+  }
+
+  public CharClass named(String description) {
+    return new CharClass(low, high, other, description);
+  }
+
+  public boolean contains(char c) {
+    if (c < 64) {
+      return ((low >>> c) & 1L) != 0;
+    } else if (c < 128) {
+      return ((high >>> (c - 64)) & 1L) != 0;
+    }
+    return other != null && other.test(c);
+  }
+
+  @Override
+  public String toString() {
+    return description;
+  }
+
+  public static final CharClass DIGIT = range('0', '9').named("digit");
+  public static final CharClass LETTER = range('a', 'z').or(range('A', 'Z')).named("letter");
+  public static final CharClass WORD = LETTER.or(DIGIT).or(of("_")).named("word character");
+  // The same set as \s in java.util.regex.
+  public static final CharClass WHITESPACE = of(" \t\n\u000B\f\r").named("whitespace");
+}
@@ -0,0 +1,659 @@
+package com.github.adonis0147.llparser;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+// A set of string() and regex() terminals as one deterministic automaton over UTF-16 chars. A match
+// reads every character once and never backtracks: it is the longest match of any terminal, the
+// first of them on a tie. Only the regular core of the pattern syntax is supported: literals,
+// escapes, classes, '.', groups, '|' and greedy quantifiers.
+final class Dfa {
+
+  private static final int MAX_STATES = 1 << 12;
+  private static final int MAX_REPEAT = 1 << 8;
+  private static final int CHARS = Character.MAX_VALUE + 1;
+
+  // Per state: the ASCII transitions, the others as intervals starting at bounds, -1 being none.
+  private final int[][] ascii;
+  private final int[][] bounds;
+  private final int[][] targets;
+  // The terminal accepted in a state, or -1.
+  private final int[] accepts;
+  private final boolean[] exits;
+
+  private Dfa(int[][] ascii, int[][] bounds, int[][] targets, int[] accepts, boolean[] exits) {
+    this.ascii = ascii;
+    this.bounds = bounds;
+    this.targets = targets;
+    this.accepts = accepts;
+    this.exits = exits;
+  }
+
+  // Null if a terminal is not a string() or regex() in the supported syntax, or the automaton gets too large.
+  static Dfa compile(Parser<?>[] terminals) {
+    Nfa nfa = new Nfa();
+    int[] starts = new int[terminals.length];
+    try {
+      for (int i = 0; i < terminals.length; ++ i) {
+        starts[i] = nfa.terminal(terminals[i], i);
+      }
+    } catch (UnsupportedOperationException e) {
+      return null;
+    }
+    return nfa.determinize(starts);
+  }
+
+  boolean matchesEmpty() {
+    return accepts[0] >= 0;
+  }
+
+  boolean canStart(int c) {
+    return step(0, (char) c) >= 0;
+  }
+
+  // The longest match at index as (terminal << 32) | end, or -1. Sets the context's hitEnd flag when
+  // the input ran out while a longer match was still possible.
+  long match(CharSequence input, int index, ParseContext context) {
+    int state = 0;
+    long longest = accepts[0] < 0 ? -1 : ((long) accepts[0] << 32) | index;
+    int length = input.length();
+    for (int i = index; ; ++ i) {
+      if (i >= length) {
+        if (exits[state]) {
+          context.hitEnd = true;
+        }
+        return longest;
+      }
+      state = step(state, input.charAt(i));
+      if (state < 0) {
+        return longest;
+      }
+      if (accepts[state] >= 0) {
+        longest = ((long) accepts[state] << 32) | (i + 1);
+      }
+    }
+  }
+
+  private int step(int state, char c) {
+    if (c < 128) {
+      return ascii[state][c];
+    }
+    int[] starts = bounds[state];
+    int position = Arrays.binarySearch(starts, c);
+    return targets[state][position < 0 ? -position - 2 : position];
+  }
+
+  private static final class Fragment {
+    final int start;
+    // An epsilon state without successors yet.
+    final int end;
+
+    Fragment(int start, int end) {
+      this.start = start;
+      this.end = end;
+    }
+  }
+
+  // A Thompson automaton. A state either reads a char of its set and moves to next, or moves to next
+  // and alternative without reading.
+  private static final class Nfa {
+    private int size;
+    private int[][] sets = new int[64][];
+    private int[] next = new int[64];
+    private int[] alternative = new int[64];
+    private int[] accepts = new int[64];
+    private int[] marks = new int[64];
+    private int generation;
+
+    int state() {
+      if (size == sets.length) {
+        int capacity = size << 1;
+        sets = Arrays.copyOf(sets, capacity);
+        next = Arrays.copyOf(next, capacity);
+        alternative = Arrays.copyOf(alternative, capacity);
+        accepts = Arrays.copyOf(accepts, capacity);
+        marks = Arrays.copyOf(marks, capacity);
+      }
+      next[size] = -1;
+      alternative[size] = -1;
+      accepts[size] = -1;
+      return size ++;
+    }
+
+    int terminal(Parser<?> parser, int terminal) {
+      if (!(parser instanceof LLParser)) {
+        throw new UnsupportedOperationException();
+      }
+      LLParser<?> node = (LLParser<?>) parser;
+      Fragment fragment;
+      if (node.kind() == LLParser.Kind.STRING) {
+        fragment = literal((String) node.operand());
+      } else if (node.kind() == LLParser.Kind.REGEX) {
+        fragment = new PatternReader(this, ((LLParser.Regex) node.operand()).pattern.pattern()).read();
+      } else {
+        throw new UnsupportedOperationException();
+      }
+      int accept = state();
+      accepts[accept] = terminal;
+      next[fragment.end] = accept;
+      return fragment.start;
+    }
+
+    Fragment empty() {
+      int state = state();
+      return new Fragment(state, state);
+    }
+
+    Fragment chars(int[] ranges) {
+      int start = state();
+      int end = state();
+      sets[start] = ranges;
+      next[start] = end;
+      return new Fragment(start, end);
+    }
+
+    Fragment literal(String literal) {
+      Fragment fragment = empty();
+      for (int i = 0; i < literal.length(); ++ i) {
+        char c = literal.charAt(i);
+        fragment = concatenation(fragment, chars(new int[] {c, c}));
+      }
+      return fragment;
+    }
+
+    Fragment concatenation(Fragment first, Fragment second) {
+      next[first.end] = second.start;
+      return new Fragment(first.start, second.end);
+    }
+
+    Fragment alternation(Fragment first, Fragment second) {
+      int start = state();
+      int end = state();
+      next[start] = first.start;
+      alternative[start] = second.start;
+      next[first.end] = end;
+      next[second.end] = end;
+      return new Fragment(start, end);
+    }
+
+    Fragment optional(Fragment fragment) {
+      int start = state();
+      int end = state();
+      next[start] = fragment.start;
+      alternative[start] = end;
+      next[fragment.end] = end;
+      return new Fragment(start, end);
+    }
+
+    Fragment plus(Fragment fragment) {
+      int end = state();
+      next[fragment.end] = fragment.start;
+      alternative[fragment.end] = end;
+      return new Fragment(fragment.start, end);
+    }
+
+    Fragment star(Fragment fragment) {
+      return optional(plus(fragment));
+    }
+
+    // The states reachable without reading, restricted to those that read or accept, in order.
+    int[] closure(int[] states, int count) {
+      ++ generation;
+      int[] stack = new int[size];
+      int top = 0;
+      int[] result = new int[size];
+      int found = 0;
+      for (int i = 0; i < count; ++ i) {
+        if (marks[states[i]] != generation) {
+          marks[states[i]] = generation;
+          stack[top ++] = states[i];
+        }
+      }
+      while (top > 0) {
+        int state = stack[-- top];
+        if (sets[state] != null || accepts[state] >= 0) {
+          result[found ++] = state;
+          continue;
+        }
+        for (int successor : new int[] {next[state], alternative[state]}) {
+          if (successor >= 0 && marks[successor] != generation) {
+            marks[successor] = generation;
+            stack[top ++] = successor;
+          }
+        }
+      }
+      result = Arrays.copyOf(result, found);
+      Arrays.sort(result);
+      return result;
+    }
+
+    // The subset construction. Null once it grows past MAX_STATES.
+    Dfa determinize(int[] starts) {
+      Map<Key, Integer> ids = new HashMap<>();
+      List<int[]> subsets = new ArrayList<>();
+      int[] initial = closure(starts, starts.length);
+      ids.put(new Key(initial), 0);
+      subsets.add(initial);
+      List<int[]> ascii = new ArrayList<>();
+      List<int[]> bounds = new ArrayList<>();
+      List<int[]> targets = new ArrayList<>();
+      List<Integer> accepted = new ArrayList<>();
+      int[] moves = new int[size];
+      for (int d = 0; d < subsets.size(); ++ d) {
+        int[] subset = subsets.get(d);
+        int accept = -1;
+        int[] cuts = new int[1];
+        int cutCount = 1;
+        for (int state : subset) {
+          if (accepts[state] >= 0 && (accept < 0 || accepts[state] < accept)) {
+            accept = accepts[state];
+          }
+          int[] ranges = sets[state];
+          if (ranges == null) {
+            continue;
+          }
+          if (cutCount + ranges.length > cuts.length) {
+            cuts = Arrays.copyOf(cuts, (cutCount + ranges.length) << 1);
+          }
+          for (int i = 0; i < ranges.length; i += 2) {
+            cuts[cutCount ++] = ranges[i];
+            cuts[cutCount ++] = ranges[i + 1] + 1;
+          }
+        }
+        Arrays.sort(cuts, 0, cutCount);
+        int[] intervalStarts = new int[cutCount];
+        int[] intervalTargets = new int[cutCount];
+        int intervals = 0;
+        for (int i = 0; i < cutCount; ++ i) {
+          int low = cuts[i];
+          if (low >= CHARS || (i > 0 && low == cuts[i - 1])) {
+            continue;
+          }
+          int count = 0;
+          for (int state : subset) {
+            if (sets[state] != null && Ranges.contains(sets[state], low)) {
+              moves[count ++] = next[state];
+            }
+          }
+          int target = -1;
+          if (count > 0) {
+            int[] successor = closure(moves, count);
+            Key key = new Key(successor);
+            Integer id = ids.get(key);
+            if (id == null) {
+              if (subsets.size() == MAX_STATES) {
+                return null;
+              }
+              id = subsets.size();
+              ids.put(key, id);
+              subsets.add(successor);
+            }
+            target = id;
+          }
+          if (intervals == 0 || intervalTargets[intervals - 1] != target) {
+            intervalStarts[intervals] = low;
+            intervalTargets[intervals] = target;
+            ++ intervals;
+          }
+        }
+        int[] stateBounds = Arrays.copyOf(intervalStarts, intervals);
+        int[] stateTargets = Arrays.copyOf(intervalTargets, intervals);
+        int[] stateAscii = new int[128];
+        for (int c = 0, interval = 0; c < 128; ++ c) {
+          while (interval + 1 < intervals && stateBounds[interval + 1] <= c) {
+            ++ interval;
+          }
+          stateAscii[c] = stateTargets[interval];
+        }
+        ascii.add(stateAscii);
+        bounds.add(stateBounds);
+        targets.add(stateTargets);
+        accepted.add(accept);
+      }
+      int count = subsets.size();
+      int[] acceptArray = new int[count];
+      boolean[] exits = new boolean[count];
+      for (int d = 0; d < count; ++ d) {
+        acceptArray[d] = accepted.get(d);
+        for (int target : targets.get(d)) {
+          exits[d] |= target >= 0;
+        }
+      }
+      return new Dfa(ascii.toArray(new int[0][]), bounds.toArray(new int[0][]), targets.toArray(new int[0][]),
+          acceptArray, exits);
+    }
+  }
+
+  private static final class Key {
+    private final int[] states;
+    private final int hash;
+
+    Key(int[] states) {
+      this.states = states;
+      this.hash = Arrays.hashCode(states);
+    }
+
+    @Override
+    public boolean equals(Object other) {
+      return other instanceof Key && Arrays.equals(states, ((Key) other).states);
+    }
+
+    @Override
+    public int hashCode() {
+      return hash;
+    }
+  }
+
+  // Sets of chars as sorted, disjoint, inclusive [low, high] pairs.
+  private static final class Ranges {
+    static final int[] DIGIT = {'0', '9'};
+    static final int[] WORD = {'0', '9', 'A', 'Z', '_', '_', 'a', 'z'};
+    static final int[] SPACE = {'\t', '\r', ' ', ' '};
+    // Everything but the line terminators, as '.' without DOTALL.
+    static final int[] DOT = negate(new int[] {'\n', '\n', '\r', '\r', '\u0085', '\u0085', '\u2028', '\u2029'});
+
+    static boolean contains(int[] ranges, int c) {
+      for (int i = 0; i < ranges.length && ranges[i] <= c; i += 2) {
+        if (c <= ranges[i + 1]) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    static int[] union(int[] first, int[] second) {
+      int[] pairs = new int[first.length + second.length];
+      System.arraycopy(first, 0, pairs, 0, first.length);
+      System.arraycopy(second, 0, pairs, first.length, second.length);
+      long[] sorted = new long[pairs.length / 2];
+      for (int i = 0; i < sorted.length; ++ i) {
+        sorted[i] = ((long) pairs[2 * i] << 32) | pairs[2 * i + 1];
+      }
+      Arrays.sort(sorted);
+      int[] result = new int[pairs.length];
+      int count = 0;
+      for (long pair : sorted) {
+        int low = (int) (pair >>> 32);
+        int high = (int) pair;
+        if (count > 0 && low <= result[count - 1] + 1) {
+          result[count - 1] = Math.max(result[count - 1], high);
+        } else {
+          result[count ++] = low;
+          result[count ++] = high;
+        }
+      }
+      return Arrays.copyOf(result, count);
+    }
+
+    static int[] negate(int[] ranges) {
+      int[] result = new int[ranges.length + 2];
+      int count = 0;
+      int low = 0;
+      for (int i = 0; i < ranges.length; i += 2) {
+        if (ranges[i] > low) {
+          result[count ++] = low;
+          result[count ++] = ranges[i] - 1;
+        }
+        low = ranges[i + 1] + 1;
+      }
+      if (low < CHARS) {
+        result[count ++] = low;
+        result[count ++] = CHARS - 1;
+      }
+      return Arrays.copyOf(result, count);
+    }
+  }
+
+  // Recursive descent over the pattern syntax, which java.util.regex has already validated.
+  // Anything outside the regular core throws UnsupportedOperationException.
+  private static final class PatternReader {
+    private final Nfa nfa;
+    private final String source;
+    private int position;
+
+    PatternReader(Nfa nfa, String source) {
+      this.nfa = nfa;
+      this.source = source;
+    }
+
+    Fragment read() {
+      Fragment fragment = alternation();
+      if (position != source.length()) {
+        throw new UnsupportedOperationException();
+      }
+      return fragment;
+    }
+
+    private boolean peek(char c) {
+      return position < source.length() && source.charAt(position) == c;
+    }
+
+    private void expect(char c) {
+      if (!peek(c)) {
+        throw new UnsupportedOperationException();
+      }
+      ++ position;
+    }
+
+    private Fragment alternation() {
+      Fragment fragment = concatenation();
+      while (peek('|')) {
+        ++ position;
+        fragment = nfa.alternation(fragment, concatenation());
+      }
+      return fragment;
+    }
+
+    private Fragment concatenation() {
+      Fragment fragment = nfa.empty();
+      while (position < source.length() && !peek('|') && !peek(')')) {
+        fragment = nfa.concatenation(fragment, repetition());
+      }
+      return fragment;
+    }
+
+    private Fragment repetition() {
+      int atomStart = position;
+      Fragment atom = atom();
+      int atomEnd = position;
+      Fragment result;
+      if (peek('*')) {
+        ++ position;
+        result = nfa.star(atom);
+      } else if (peek('+')) {
+        ++ position;
+        result = nfa.plus(atom);
+      } else if (peek('?')) {
+        ++ position;
+        result = nfa.optional(atom);
+      } else if (peek('{')) {
+        result = bounded(atom, atomStart, atomEnd);
+      } else {
+        return atom;
+      }
+      // Lazy and possessive quantifiers choose a match other than the longest.
+      if (position < source.length() && "*+?{".indexOf(source.charAt(position)) >= 0) {
+        throw new UnsupportedOperationException();
+      }
+      return result;
+    }
+
+    // atom{min}, atom{min,} and atom{min,max}, with a fresh copy of the atom per repetition.
+    private Fragment bounded(Fragment atom, int atomStart, int atomEnd) {
+      expect('{');
+      int min = number();
+      int max = min;
+      if (peek(',')) {
+        ++ position;
+        max = peek('}') ? -1 : number();
+      }
+      expect('}');
+      int end = position;
+      Fragment result = nfa.empty();
+      int copies = max < 0 ? min + 1 : max;
+      for (int i = 0; i < copies; ++ i) {
+        Fragment copy = atom;
+        if (i > 0) {
+          position = atomStart;
+          copy = atom();
+          position = end;
+        }
+        if (i < min) {
+          result = nfa.concatenation(result, copy);
+        } else {
+          result = nfa.concatenation(result, max < 0 ? nfa.star(copy) : nfa.optional(copy));
+        }
+      }
+      return result;
+    }
+
+    private int number() {
+      int start = position;
+      int value = 0;
+      while (position < source.length() && Character.isDigit(source.charAt(position))) {
+        value = value * 10 + (source.charAt(position ++) - '0');
+        if (value > MAX_REPEAT) {
+          throw new UnsupportedOperationException();
+        }
+      }
+      if (position == start) {
+        throw new UnsupportedOperationException();
+      }
+      return value;
+    }
+
+    private Fragment atom() {
+      char c = source.charAt(position ++);
+      switch (c) {
+        case '(': {
+          if (peek('?')) {
+            if (!source.startsWith("?:", position)) {
+              throw new UnsupportedOperationException();
+            }
+            position += 2;
+          }
+          Fragment fragment = alternation();
+          expect(')');
+          return fragment;
+        }
+        case '[':
+          return nfa.chars(charClass());
+        case '.':
+          return nfa.chars(Ranges.DOT);
+        case '\\':
+          return nfa.chars(escape());
+        case '^':
+        case '$':
+        case ')':
+        case '|':
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+          throw new UnsupportedOperationException();
+        default:
+          return nfa.chars(new int[] {c, c});
+      }
+    }
+
+    // The set of an escape, after the backslash.
+    private int[] escape() {
+      char c = source.charAt(position ++);
+      switch (c) {
+        case 'd':
+          return Ranges.DIGIT;
+        case 'D':
+          return Ranges.negate(Ranges.DIGIT);
+        case 'w':
+          return Ranges.WORD;
+        case 'W':
+          return Ranges.negate(Ranges.WORD);
+        case 's':
+          return Ranges.SPACE;
+        case 'S':
+          return Ranges.negate(Ranges.SPACE);
+        case 't':
+          return single('\t');
+        case 'n':
+          return single('\n');
+        case 'r':
+          return single('\r');
+        case 'f':
+          return single('\f');
+        case 'a':
+          return single('\u0007');
+        case 'e':
+          return single('\u001B');
+        case 'x':
+          return single(hex(2));
+        case 'u':
+          return single(hex(4));
+        default:
+          // Other letters and digits are classes, anchors or back references.
+          if (Character.isLetterOrDigit(c)) {
+            throw new UnsupportedOperationException();
+          }
+          return single(c);
+      }
+    }
+
+    private static int[] single(int c) {
+      return new int[] {c, c};
+    }
+
+    private int hex(int digits) {
+      if (position + digits > source.length()) {
+        throw new UnsupportedOperationException();
+      }
+      int value = 0;
+      for (int i = 0; i < digits; ++ i) {
+        int digit = Character.digit(source.charAt(position ++), 16);
+        if (digit < 0) {
+          throw new UnsupportedOperationException();
+        }
+        value = value * 16 + digit;
+      }
+      return value;
+    }
+
+    // [...] after the '['. Nested classes and intersections are not supported.
+    private int[] charClass() {
+      boolean negated = peek('^');
+      if (negated) {
+        ++ position;
+      }
+      if (peek(']')) {
+        throw new UnsupportedOperationException();
+      }
+      int[] ranges = new int[0];
+      while (!peek(']')) {
+        if (peek('[') || source.startsWith("&&", position)) {
+          throw new UnsupportedOperationException();
+        }
+        int[] item = classItem();
+        if (peek('-') && position + 1 < source.length() && source.charAt(position + 1) != ']') {
+          ++ position;
+          int[] high = classItem();
+          if (item.length != 2 || item[0] != item[1] || high.length != 2 || high[0] != high[1]) {
+            throw new UnsupportedOperationException();
+          }
+          item = new int[] {item[0], high[0]};
+        }
+        ranges = Ranges.union(ranges, item);
+      }
+      expect(']');
+      return negated ? Ranges.negate(ranges) : ranges;
+    }
+
+    private int[] classItem() {
+      if (position >= source.length()) {
+        throw new UnsupportedOperationException();
+      }
+      char c = source.charAt(position ++);
+      return c == '\\' ? escape() : single(c);
+    }
+  }
+}
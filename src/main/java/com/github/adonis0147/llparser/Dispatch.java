@@ -0,0 +1,100 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+
+// Which branches of an alternative are worth trying on the next character. An ASCII character is
+// looked up in a table, anything else is filtered once and kept in a small direct mapped cache;
+// without any known first set every character routes to all branches. The expectations of the
+// branches skipped in between are kept, so the reported error is the same as if every branch had
+// failed.
+final class Dispatch {
+
+  // branches[k] is tried after recording gaps[k]. gaps[branches.length] follows the last one.
+  static final class Route {
+    final int[] branches;
+    final List<String>[] gaps;
+
+    Route(int[] branches, List<String>[] gaps) {
+      this.branches = branches;
+      this.gaps = gaps;
+    }
+  }
+
+  // A cached route for a non-ASCII character. Final fields publish it safely to other threads.
+  private static final class Cached {
+    final char c;
+    final Route route;
+
+    Cached(char c, Route route) {
+      this.c = c;
+      this.route = route;
+    }
+  }
+
+  private static final int CACHE_SIZE = 256;
+
+  private final FirstSet[] firsts;
+  private final boolean known;
+  private final Route all;
+  private final Route[] ascii;
+  // Racy by design: a lost or overwritten entry is only computed again.
+  private final Cached[] cache = new Cached[CACHE_SIZE];
+
+  Dispatch(Parser[] parsers) {
+    firsts = new FirstSet[parsers.length];
+    boolean known = false;
+    for (int i = 0; i < parsers.length; ++ i) {
+      firsts[i] = FirstSet.of(parsers[i]);
+      known |= firsts[i] != null;
+    }
+    this.known = known;
+    all = route(-1);
+    ascii = new Route[128];
+    for (int c = 0; c < ascii.length; ++ c) {
+      ascii[c] = known ? route(c) : all;
+    }
+  }
+
+  Route route(CharSequence input, int index) {
+    if (index >= input.length()) {
+      return all;
+    }
+    char c = input.charAt(index);
+    if (c < 128) {
+      return ascii[c];
+    }
+    if (!known) {
+      return all;
+    }
+    int slot = c & (CACHE_SIZE - 1);
+    Cached cached = cache[slot];
+    if (cached == null || cached.c != c) {
+      cached = new Cached(c, route(c));
+      cache[slot] = cached;
+    }
+    return cached.route;
+  }
+
+  // c < 0 keeps every branch.
+  @SuppressWarnings("unchecked")
+  private Route route(int c) {
+    int[] branches = new int[firsts.length];
+    List<String>[] gaps = new List[firsts.length + 1];
+    int count = 0;
+    List<String> gap = null;
+    for (int i = 0; i < firsts.length; ++ i) {
+      FirstSet first = firsts[i];
+      if (c < 0 || first == null || first.chars.contains((char) c)) {
+        branches[count] = i;
+        gaps[count ++] = gap;
+        gap = null;
+      } else {
+        gap = Expected.union(gap == null ? Collections.<String>emptyList() : gap, first.expected);
+      }
+    }
+    gaps[count] = gap;
+    return new Route(Arrays.copyOf(branches, count), Arrays.copyOf(gaps, count + 1));
+  }
+}
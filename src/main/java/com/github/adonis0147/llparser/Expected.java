@@ -0,0 +1,82 @@
+package com.github.adonis0147.llparser;
+
+import java.util.AbstractList;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Deque;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Set;
+
+// An immutable, structurally shared list of expectations. Unions are O(1) and the
+// deduplicated list is only built when somebody actually reads it. Leaves are shared by every parse
+// of a parser, on any thread, so the built list is published through a volatile field.
+final class Expected extends AbstractList<String> {
+
+  private final String description;
+  private final List<String> left;
+  private final List<String> right;
+  private volatile List<String> items;
+
+  private Expected(String description, List<String> left, List<String> right) {
+    this.description = description;
+    this.left = left;
+    this.right = right;
+    this.items = description == null ? null : Collections.singletonList(description);
+  }
+
+  static List<String> of(String description) {
+    return new Expected(description, null, null);
+  }
+
+  static List<String> union(List<String> left, List<String> right) {
+    if (left == right || isEmpty(right)) {
+      return left;
+    } else if (isEmpty(left)) {
+      return right;
+    }
+    return new Expected(null, left, right);
+  }
+
+  private static boolean isEmpty(List<String> list) {
+    return !(list instanceof Expected) && list.isEmpty();
+  }
+
+  @Override
+  public String get(int index) {
+    return items().get(index);
+  }
+
+  @Override
+  public int size() {
+    return items().size();
+  }
+
+  private List<String> items() {
+    List<String> items = this.items;
+    if (items == null) {
+      Set<String> set = new LinkedHashSet<>();
+      Deque<List<String>> stack = new ArrayDeque<>();
+      stack.push(this);
+      while (!stack.isEmpty()) {
+        List<String> list = stack.pop();
+        if (!(list instanceof Expected)) {
+          set.addAll(list);
+          continue;
+        }
+        Expected expected = (Expected) list;
+        List<String> built = expected.items;
+        if (built != null) {
+          set.addAll(built);
+        } else {
+          stack.push(expected.right);
+          stack.push(expected.left);
+        }
+      }
+      items = Collections.unmodifiableList(new ArrayList<>(set));
+      this.items = items;
+    }
+    return items;
+  }
+}
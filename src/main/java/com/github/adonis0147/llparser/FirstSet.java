@@ -0,0 +1,110 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Collections;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+// The characters a parser can start with. On any other character it fails right away, at the same
+// index and with the given expectation, so an alternative may skip it without calling it.
+// A parser without a known set is represented by null and is always tried.
+final class FirstSet {
+
+  final CharClass chars;
+  final List<String> expected;
+
+  FirstSet(CharClass chars, List<String> expected) {
+    this.chars = chars;
+    this.expected = expected;
+  }
+
+  static FirstSet of(Parser parser) {
+    return of(parser, new IdentityHashMap<>());
+  }
+
+  // A parser that is still on the stack is left recursive and gets no set.
+  private static FirstSet of(Parser parser, Map<Parser, FirstSet> known) {
+    if (!(parser instanceof LLParser)) {
+      return null;
+    }
+    if (known.containsKey(parser)) {
+      return known.get(parser);
+    }
+    known.put(parser, null);
+    FirstSet first = compute((LLParser) parser, known);
+    known.put(parser, first);
+    return first;
+  }
+
+  private static FirstSet compute(LLParser llParser, Map<Parser, FirstSet> known) {
+    Parser[] children = llParser.children();
+    switch (llParser.kind()) {
+      case TERMINAL:
+        return (FirstSet) llParser.operand();
+      case STRING: {
+        String literal = (String) llParser.operand();
+        return new FirstSet(CharClass.of(literal.substring(0, 1)), Expected.of(literal));
+      }
+      case REGEX:
+        return ((LLParser.Regex) llParser.operand()).first;
+      case SEQUENCE:
+        return children.length == 0 ? null : of(children[0], known);
+      case SKIP:
+      case THEN:
+      case COMBINE:
+        return of(children[0], known);
+      case TIMES:
+        return ((int[]) llParser.operand())[0] == 0 ? null : of(children[0], known);
+      case CHAIN:
+        // With prefix operators an expression does not start like its operand.
+        if (llParser.operand() instanceof OperatorTable
+            && ((OperatorTable<?>) llParser.operand()).prefixes.length > 0) {
+          return null;
+        }
+        return of(children[0], known);
+      case MAP:
+      case COMMIT:
+      case NAMED:
+      case BUILD:
+        return of(children[0], known);
+      case ALTERNATIVE: {
+        if (children.length == 0) {
+          return null;
+        }
+        CharClass chars = null;
+        List<String> expected = Collections.emptyList();
+        for (Parser child : children) {
+          FirstSet first = of(child, known);
+          if (first == null) {
+            return null;
+          }
+          chars = chars == null ? first.chars : chars.or(first.chars);
+          expected = Expected.union(expected, first.expected);
+        }
+        return new FirstSet(chars, expected);
+      }
+      case REFERENCE:
+        return of(((LLParser.Reference) llParser.operand()).get(), known);
+      default:
+        return null;
+    }
+  }
+
+  // Probes every ASCII character on its own: one the pattern neither matches nor needs more input
+  // after cannot start a match. Patterns that look behind the start are left unknown.
+  static FirstSet ofPattern(Pattern pattern, List<String> expected) {
+    String source = pattern.pattern();
+    if (source.contains("(?<=") || source.contains("(?<!") || source.contains("\\b") || source.contains("\\B")) {
+      return null;
+    }
+    CharClass chars = CharClass.matching(c -> c >= 128 || canStart(pattern, (char) c), source);
+    return new FirstSet(chars, expected);
+  }
+
+  private static boolean canStart(Pattern pattern, char c) {
+    Matcher matcher = pattern.matcher(String.valueOf(c));
+    return matcher.lookingAt() || matcher.hitEnd();
+  }
+}
@@ -0,0 +1,6 @@
+package com.github.adonis0147.llparser;
+
+@FunctionalInterface
+public interface Function3<A, B, C, R> {
+  R apply(A first, B second, C third);
+}
@@ -0,0 +1,6 @@
+package com.github.adonis0147.llparser;
+
+@FunctionalInterface
+public interface Function4<A, B, C, D, R> {
+  R apply(A first, B second, C third, D fourth);
+}
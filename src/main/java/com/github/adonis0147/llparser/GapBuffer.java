@@ -0,0 +1,88 @@
+package com.github.adonis0147.llparser;
+
+// The text of an IncrementalParser: one char array with a gap at the last edit, so an edit costs the
+// characters between it and the previous one instead of a copy of the whole document.
+final class GapBuffer implements CharSequence {
+
+  private static final int MIN_GAP = 64;
+
+  private char[] chars;
+  private int gapStart;
+  private int gapEnd;
+
+  GapBuffer(String text) {
+    chars = new char[text.length() + MIN_GAP];
+    text.getChars(0, text.length(), chars, 0);
+    gapStart = text.length();
+    gapEnd = chars.length;
+  }
+
+  // Replaces removed characters at offset with inserted. The caller checks the bounds.
+  void replace(int offset, int removed, String inserted) {
+    moveGap(offset);
+    gapEnd += removed;
+    int length = inserted.length();
+    if (gapEnd - gapStart < length) {
+      grow(length);
+    }
+    inserted.getChars(0, length, chars, gapStart);
+    gapStart += length;
+  }
+
+  @Override
+  public int length() {
+    return chars.length - (gapEnd - gapStart);
+  }
+
+  @Override
+  public char charAt(int index) {
+    return chars[index < gapStart ? index : index + (gapEnd - gapStart)];
+  }
+
+  @Override
+  public CharSequence subSequence(int start, int end) {
+    if (start < 0 || start > end || end > length()) {
+      throw new IndexOutOfBoundsException("start " + start + ", end " + end + ", length " + length());
+    }
+    if (end <= gapStart) {
+      return new String(chars, start, end - start);
+    }
+    int gap = gapEnd - gapStart;
+    if (start >= gapStart) {
+      return new String(chars, start + gap, end - start);
+    }
+    return new StringBuilder(end - start)
+        .append(chars, start, gapStart - start)
+        .append(chars, gapEnd, end - gapStart)
+        .toString();
+  }
+
+  @Override
+  public String toString() {
+    return subSequence(0, length()).toString();
+  }
+
+  private void moveGap(int offset) {
+    if (offset < gapStart) {
+      int count = gapStart - offset;
+      System.arraycopy(chars, offset, chars, gapEnd - count, count);
+      gapStart = offset;
+      gapEnd -= count;
+    } else if (offset > gapStart) {
+      int count = offset - gapStart;
+      System.arraycopy(chars, gapEnd, chars, gapStart, count);
+      gapStart = offset;
+      gapEnd += count;
+    }
+  }
+
+  private void grow(int needed) {
+    int capacity = Math.max(chars.length << 1, length() + needed + MIN_GAP);
+    char[] grown = new char[capacity];
+    System.arraycopy(chars, 0, grown, 0, gapStart);
+    int tail = chars.length - gapEnd;
+    System.arraycopy(chars, gapEnd, grown, capacity - tail, tail);
+    chars = grown;
+    gapEnd = capacity - tail;
+  }
+}
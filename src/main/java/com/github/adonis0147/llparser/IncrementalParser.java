@@ -0,0 +1,57 @@
+package com.github.adonis0147.llparser;
+
+// Reparses a document after an edit, reusing the memo table of the previous parse. Every node is
+// memoized together with the extent of the input it read. After an edit, the entries that read only
+// text before the edit, or that start after it, are kept, the latter moved by the change in length
+// when they are next looked up. The document lives in a gap buffer, so an edit costs about the
+// distance from the previous one. An instance keeps the state of one document and is not thread-safe.
+public final class IncrementalParser<T> {
+
+  private final Parser<T> parser;
+  private final ParseContext context = new ParseContext();
+  private GapBuffer text;
+
+  public IncrementalParser(Parser<T> parser) {
+    if (parser == null) {
+      throw new IllegalArgumentException("The parser is null.");
+    }
+    this.parser = parser.skip(LLParser.EOF);
+  }
+
+  public String text() {
+    return text == null ? null : text.toString();
+  }
+
+  public Result<T> parse(String text) {
+    if (text == null) {
+      throw new IllegalArgumentException("The input text is null.");
+    }
+    context.memo.clear();
+    this.text = new GapBuffer(text);
+    return run();
+  }
+
+  // Replaces removed characters at offset with inserted and parses the result.
+  public Result<T> edit(int offset, int removed, String inserted) {
+    if (text == null) {
+      throw new IllegalStateException("Nothing has been parsed yet.");
+    }
+    if (offset < 0 || removed < 0 || offset + removed > text.length() || inserted == null) {
+      throw new IllegalArgumentException("Invalid edit.");
+    }
+    context.memo.edit(offset, removed, inserted.length());
+    text.replace(offset, removed, inserted);
+    return run();
+  }
+
+  private Result<T> run() {
+    context.enter();
+    context.memo.resetFloor();
+    context.packrat = true;
+    try {
+      return context.complete(parser.parse(new TrackedInput(text, context), 0, context));
+    } finally {
+      context.leave();
+    }
+  }
+}
@@ -0,0 +1,104 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Collections;
+import java.util.List;
+import java.util.function.Function;
+import java.util.function.IntBinaryOperator;
+import java.util.function.IntUnaryOperator;
+
+// A parser of ints that can hand them over unboxed. matchInt() leaves the value in the context and
+// the combinators below stay on that path, so a value is only boxed where it goes on to a generic
+// parser. Memoization and the Profiler only see parse().
+public class IntParser extends LLParser<Integer> {
+
+  // Returns ParseContext.intMatch() on success and ParseContext.intFailure() on failure.
+  @FunctionalInterface
+  public interface IntParseFunction {
+    int apply(CharSequence input, int index, ParseContext context);
+  }
+
+  private final IntParseFunction function;
+
+  public IntParser(IntParseFunction function) {
+    this(Kind.OPAQUE, null, NO_CHILDREN, function);
+  }
+
+  IntParser(Kind kind, Object operand, Parser[] children, IntParseFunction function) {
+    super(kind, operand, children, boxed(function));
+    this.function = function;
+  }
+
+  private static ParseFunction<Integer> boxed(IntParseFunction function) {
+    return (input, index, context) -> {
+      int end = function.apply(input, index, context);
+      if (end >= 0) {
+        return Result.success(context.intValue, end);
+      }
+      int failureIndex = ~end;
+      List<String> expected = context.failureIndex == failureIndex
+          ? context.failureExpected
+          : Collections.<String>emptyList();
+      return new Result<>(Status.FAILURE, failureIndex, expected);
+    };
+  }
+
+  // The end of the match with the value in context.intValue(), or ~ of the failure index.
+  public int matchInt(CharSequence input, int index, ParseContext context) {
+    return function.apply(input, index, context);
+  }
+
+  public IntParser mapToInt(IntUnaryOperator mapper) {
+    return new IntParser((input, index, context) -> {
+      int end = matchInt(input, index, context);
+      return end < 0 ? end : context.intMatch(mapper.applyAsInt(context.intValue), end);
+    });
+  }
+
+  // An IntParser for any parser of ints, unboxing its results.
+  public static IntParser unboxed(Parser<? extends Integer> parser) {
+    if (parser instanceof IntParser) {
+      return (IntParser) parser;
+    }
+    // A MAP to itself for compile(), which keeps every value boxed anyway.
+    return new IntParser(Kind.MAP, Function.identity(), new Parser[] {parser}, (input, index, context) -> {
+      Result<? extends Integer> result = parser.parse(input, index, context);
+      return result.status == Status.SUCCESS ? context.intMatch(result.value, result.index) : ~result.index;
+    });
+  }
+
+  // this (operator this)*, folded from the left without boxing the operands.
+  public IntParser chainl(Parser<? extends IntBinaryOperator> operator) {
+    return chainl(operator, (arena, left, combiner, right) -> combiner.applyAsInt(left, right));
+  }
+
+  // Like chainl(operator), with the combiner adding a node for every operator to the parse's Arena.
+  public <O> IntParser chainl(Parser<O> operator, Arena.Combiner<? super O> combiner) {
+    return new IntParser(Kind.CHAIN, combiner, new Parser[] {this, operator}, (input, index, context) -> {
+      int end = matchInt(input, index, context);
+      if (end < 0) {
+        return end;
+      }
+      int value = context.intValue;
+      for (;;) {
+        int failureIndex = context.failureIndex;
+        List<String> failureExpected = context.failureExpected;
+        boolean cut = context.cut;
+        context.cut = false;
+        Result<O> result = operator.parse(input, end, context);
+        int right = result.status == Status.SUCCESS ? matchInt(input, result.index, context) : ~result.index;
+        if (right < 0) {
+          if (context.cut) {
+            return right;
+          }
+          context.failureIndex = failureIndex;
+          context.failureExpected = failureExpected;
+          context.cut = cut;
+          return context.intMatch(value, end);
+        }
+        context.cut |= cut;
+        value = combiner.combine(context.arena, value, result.value, context.intValue);
+        end = right;
+      }
+    });
+  }
+}
@@ -1,74 +1,253 @@
 package com.github.adonis0147.llparser;
 
+import com.github.adonis0147.llparser.OperatorTable.Associativity;
+
+import java.nio.CharBuffer;
 import java.util.ArrayList;
-import java.util.LinkedHashSet;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.LinkedHashMap;
 import java.util.List;
-import java.util.Set;
+import java.util.Map;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.RecursiveAction;
+import java.util.concurrent.atomic.AtomicInteger;
 import java.util.function.BiFunction;
+import java.util.function.Consumer;
 import java.util.function.Function;
+import java.util.function.Supplier;
 import java.util.regex.Matcher;
 import java.util.regex.Pattern;
 
-public class LLParser implements Parser {
+public class LLParser<T> implements Parser<T> {
+
+  private static final AtomicInteger NEXT_ID = new AtomicInteger();
+
+  static final Parser[] NO_CHILDREN = new Parser[0];
 
-  private final BiFunction<String, Integer, Result> action;
+  private final int id = NEXT_ID.getAndIncrement();
+  private final ParseFunction action;
+  private final boolean memoized;
+  // What the node is built from, so that compile() can lower it. OPAQUE nodes are only ever called.
+  private final Kind kind;
+  private final Object operand;
+  private final Parser[] children;
+  private Parser<T> untilEof;
 
-  public LLParser(BiFunction<String, Integer, Result> action) {
+  // Give the type argument, new LLParser<String>((input, index) -> ...): a raw new LLParser(...) erases
+  // the BiFunction, leaving the lambda's input and index typed Object. of() needs no type argument.
+  public LLParser(BiFunction<String, Integer, Result<T>> action) {
+    this((input, index, context) -> {
+      Result result = action.apply(context.string(input), index);
+      // The String copy is read without being tracked, so the result may depend on all of it.
+      if (result.index >= input.length() || input instanceof TrackedInput) {
+        context.hitEnd = true;
+      }
+      if (result.status == Status.FAILURE) {
+        context.fail(result.index, result.expected);
+      }
+      return result;
+    });
+  }
+
+  public LLParser(ParseFunction<T> action) {
+    this(action, false);
+  }
+
+  private LLParser(ParseFunction action, boolean memoized) {
+    this(action, memoized, Kind.OPAQUE, null, NO_CHILDREN);
+  }
+
+  LLParser(Kind kind, Object operand, Parser[] children, ParseFunction action) {
+    this(action, false, kind, operand, children);
+  }
+
+  private LLParser(ParseFunction action, boolean memoized, Kind kind, Object operand, Parser[] children) {
     this.action = action;
+    this.memoized = memoized;
+    this.kind = kind;
+    this.operand = operand;
+    this.children = children;
   }
 
-  public static Parser lazy(final Parser parser) {
-    return new LLParser(((LLParser) parser).action);
+  // Like the BiFunction constructor, with the type of the parser inferred from the lambda.
+  public static <T> Parser<T> of(BiFunction<String, Integer, Result<T>> action) {
+    return new LLParser<>(action);
   }
 
-  public static Parser string(String expected) {
+  public static <T> Parser<T> lazy(final Parser<T> parser) {
+    LLParser llParser = (LLParser) parser;
+    return new LLParser<>(llParser.action, llParser.memoized, llParser.kind, llParser.operand, llParser.children);
+  }
+
+  // A forward reference for recursive grammars. The supplier is asked once, on first use.
+  public static <T> Parser<T> lazy(Supplier<? extends Parser<T>> supplier) {
+    Reference reference = new Reference(supplier);
+    return new LLParser<>(Kind.REFERENCE, reference, NO_CHILDREN,
+        (input, index, context) -> reference.get().parse(input, index, context));
+  }
+
+  public static Parser<String> string(String expected) {
     if (Utils.isStringNullOrEmpty(expected)) {
       throw new IllegalArgumentException("String is null or empty.");
     }
 
-    return new LLParser((input, index) -> {
-      int end = Math.min(input.length(), index + expected.length());
-      String fetched = input.substring(index, end);
-      if (expected.equals(fetched)) {
-        return new Result<String>(Status.SUCCESS, fetched, end);
-      } else {
-        return new Result<String>(Status.FAILURE, index, expected);
+    String literal = expected.intern();
+    int length = literal.length();
+    List<String> expectation = Expected.of(literal);
+    return new LLParser<>(Kind.STRING, literal, NO_CHILDREN, (input, index, context) -> {
+      if (Utils.regionMatches(input, index, literal)) {
+        return new Result<String>(Status.SUCCESS, literal, index + length);
       }
+      if (index + length > input.length()) {
+        context.hitEnd = true;
+      }
+      return context.failure(index, expectation);
+    });
+  }
+
+  // The longest of the literals at the index, in a single pass over the input.
+  public static Parser<String> oneOf(String ...literals) {
+    Map<String, String> values = new LinkedHashMap<>();
+    for (String literal : literals) {
+      if (Utils.isStringNullOrEmpty(literal)) {
+        throw new IllegalArgumentException("String is null or empty.");
+      }
+      values.put(literal, literal.intern());
+    }
+    return oneOf(values);
+  }
+
+  // Like oneOf(String...), with the value of the matched literal as the result.
+  public static <T> Parser<T> oneOf(Map<String, ? extends T> values) {
+    if (values == null || values.isEmpty()) {
+      throw new IllegalArgumentException("Literals are null or empty.");
+    }
+    List<String> expectation = Collections.emptyList();
+    for (String literal : values.keySet()) {
+      if (Utils.isStringNullOrEmpty(literal)) {
+        throw new IllegalArgumentException("String is null or empty.");
+      }
+      expectation = Expected.union(expectation, Expected.of(literal));
+    }
+    List<String> expected = expectation;
+    Trie trie = new Trie(values);
+    FirstSet first = new FirstSet(CharClass.of(trie.firstChars()), expected);
+    return new LLParser<>(Kind.TERMINAL, first, NO_CHILDREN, (input, index, context) -> {
+      Trie.Node node = trie.match(input, index, context);
+      if (node == null) {
+        return context.failure(index, expected);
+      }
+      return new Result(Status.SUCCESS, node.value, index + node.depth);
     });
   }
 
-  public static Parser regex(String patternString) {
+  public static Parser<String> regex(String patternString) {
     return regex(patternString, 0);
   }
 
-  public static Parser regex(String patternString, int group) {
+  public static Parser<String> regex(String patternString, int group) {
     if (Utils.isStringNullOrEmpty(patternString)) {
       throw new IllegalArgumentException("String is null or empty.");
     }
 
-    return new LLParser(new BiFunction<String, Integer, Result>() {
-      final Pattern pattern = Pattern.compile("^(?:" + patternString + ")");
+    Pattern pattern = Pattern.compile(patternString);
+    List<String> expectation = Expected.of("regular expression: " + patternString);
+    Regex regex = new Regex(pattern, group, expectation, FirstSet.ofPattern(pattern, expectation));
+    return new LLParser<>(Kind.REGEX, regex, NO_CHILDREN, (input, index, context) -> {
+      Matcher matcher = context.matcher(pattern, input);
+      matcher.region(index, input.length());
+      boolean matched = matcher.lookingAt();
+      if (matcher.hitEnd()) {
+        context.hitEnd = true;
+      }
+      if (matched) {
+        return new Result<String>(Status.SUCCESS, matcher.group(group), matcher.end());
+      } else {
+        return context.failure(index, expectation);
+      }
+    });
+  }
 
-      @Override
-      public Result apply(String input, Integer index) {
-        Matcher matcher = pattern.matcher(input);
-        matcher.region(index, input.length());
-        if (matcher.find()) {
-          String fetched = matcher.group(group);
-          return new Result<String>(Status.SUCCESS, fetched, index + matcher.group(0).length());
-        } else {
-          return new Result<String>(Status.FAILURE, index, "regular expression: " + patternString);
-        }
+  public static Parser<String> character(CharClass charClass) {
+    List<String> expectation = Expected.of(charClass.toString());
+    FirstSet first = new FirstSet(charClass, expectation);
+    return new LLParser<>(Kind.TERMINAL, first, NO_CHILDREN, (input, index, context) -> {
+      if (index >= input.length()) {
+        context.hitEnd = true;
+      } else if (charClass.contains(input.charAt(index))) {
+        return new Result<String>(Status.SUCCESS, String.valueOf(input.charAt(index)), index + 1);
       }
+      return context.failure(index, expectation);
     });
   }
 
-  public static Parser sequence(final Parser ...parsers) {
-    return new LLParser((input, index) -> {
+  public static Parser<String> span(CharClass charClass, int min) {
+    if (min < 0) {
+      throw new IllegalArgumentException("Min is negative.");
+    }
+    List<String> expectation = Expected.of(charClass.toString());
+    FirstSet first = min == 0 ? null : new FirstSet(charClass, expectation);
+    return new LLParser<>(first == null ? Kind.OPAQUE : Kind.TERMINAL, first, NO_CHILDREN, (input, index, context) -> {
+      int end = index;
+      int length = input.length();
+      while (end < length && charClass.contains(input.charAt(end))) {
+        ++ end;
+      }
+      if (end == length) {
+        context.hitEnd = true;
+      }
+      if (end - index < min) {
+        return context.failure(index, expectation);
+      }
+      return new Result<String>(Status.SUCCESS, input.subSequence(index, end).toString(), end);
+    });
+  }
+
+  // The longest match of any of the string() and regex() terminals, the first of them on a tie. They
+  // are compiled into one DFA that reads each character once, so unlike alternative() the choice is not
+  // ordered and a regex matches its longest text rather than java.util.regex's first one.
+  public static Parser<String> longest(Parser<?> ...terminals) {
+    if (terminals == null || terminals.length == 0) {
+      throw new IllegalArgumentException("Terminals are null or empty.");
+    }
+    String[] literals = new String[terminals.length];
+    List<String> expectation = Collections.emptyList();
+    for (int i = 0; i < terminals.length; ++ i) {
+      LLParser<?> terminal = terminals[i] instanceof LLParser ? (LLParser<?>) terminals[i] : null;
+      if (terminal != null && terminal.kind == Kind.STRING) {
+        literals[i] = (String) terminal.operand;
+        expectation = Expected.union(expectation, Expected.of(literals[i]));
+      } else if (terminal != null && terminal.kind == Kind.REGEX && ((Regex) terminal.operand).group == 0) {
+        expectation = Expected.union(expectation, ((Regex) terminal.operand).expectation);
+      } else {
+        throw new IllegalArgumentException("Not a string() or regex() of the whole match: " + terminals[i]);
+      }
+    }
+    Dfa dfa = Dfa.compile(terminals);
+    if (dfa == null) {
+      throw new IllegalArgumentException("The terminals are not regular or too large for a DFA.");
+    }
+    List<String> expected = expectation;
+    FirstSet first = dfa.matchesEmpty() ? null : new FirstSet(CharClass.matching(dfa::canStart, "longest"), expected);
+    return new LLParser<>(first == null ? Kind.OPAQUE : Kind.TERMINAL, first, NO_CHILDREN, (input, index, context) -> {
+      long match = dfa.match(input, index, context);
+      if (match < 0) {
+        return context.failure(index, expected);
+      }
+      int terminal = (int) (match >>> 32);
+      int end = (int) match;
+      String value = literals[terminal] != null ? literals[terminal] : input.subSequence(index, end).toString();
+      return new Result<String>(Status.SUCCESS, value, end);
+    });
+  }
+
+  @SafeVarargs
+  public static <T> Parser<List<T>> sequence(final Parser<? extends T> ...parsers) {
+    return new LLParser<>(Kind.SEQUENCE, null, parsers, (input, index, context) -> {
       List<Object> values = new ArrayList<>(parsers.length);
-      Result result = null;
       for (int i = 0; i < parsers.length; ++ i) {
-        result = merge(result, parsers[i].parse(input, index));
+        Result result = parsers[i].parse(input, index, context);
         if (result.status == Status.FAILURE) {
           return result;
         }
@@ -79,107 +258,558 @@ public class LLParser implements Parser {
     });
   }
 
-  private static Result merge(Result result, Result newResult) {
-    if (result == null || newResult.index > result.index) {
-      return newResult;
-    } else if (result.index > newResult.index) {
-      return result;
-    }
-    Set<String> expected = new LinkedHashSet<>(result.expected.size() + newResult.expected.size());
-    expected.addAll(result.expected);
-    expected.addAll(newResult.expected);
-    return new Result(
-        newResult.status,
-        newResult.value,
-        newResult.index,
-        new ArrayList<>(expected)
-    );
+  // The typed sequences hand the values straight to the combiner instead of building a list.
+  public static <A, B, R> Parser<R> sequence(Parser<A> first, Parser<B> second,
+                                             BiFunction<? super A, ? super B, ? extends R> combiner) {
+    return new LLParser<>(Kind.COMBINE, combiner, new Parser[] {first, second}, (input, index, context) -> {
+      Result<A> left = first.parse(input, index, context);
+      if (left.status == Status.FAILURE) {
+        return left;
+      }
+      Result<B> right = second.parse(input, left.index, context);
+      if (right.status == Status.FAILURE) {
+        return right;
+      }
+      return new Result<R>(Status.SUCCESS, combiner.apply(left.value, right.value), right.index);
+    });
   }
 
-  public static Parser alternative(final Parser ...parsers) {
-    return new LLParser((input, index) -> {
-      Result result = null;
+  public static <A, B, C, R> Parser<R> sequence(Parser<A> first, Parser<B> second, Parser<C> third,
+                                                Function3<? super A, ? super B, ? super C, ? extends R> combiner) {
+    return combined(new Parser[] {first, second, third}, combiner);
+  }
+
+  public static <A, B, C, D, R> Parser<R> sequence(
+      Parser<A> first, Parser<B> second, Parser<C> third, Parser<D> fourth,
+      Function4<? super A, ? super B, ? super C, ? super D, ? extends R> combiner) {
+    return combined(new Parser[] {first, second, third, fourth}, combiner);
+  }
+
+  private static <R> Parser<R> combined(Parser[] parsers, Object combiner) {
+    return new LLParser<>(Kind.COMBINE, combiner, parsers, (input, index, context) -> {
+      Object[] values = new Object[parsers.length];
       for (int i = 0; i < parsers.length; ++ i) {
-        result = merge(result, parsers[i].parse(input, index));
-        if (result.status == Status.SUCCESS) {
+        Result result = parsers[i].parse(input, index, context);
+        if (result.status == Status.FAILURE) {
           return result;
         }
+        values[i] = result.value;
+        index = result.index;
       }
-      return result;
+      return new Result(Status.SUCCESS, combine(combiner, values, 0, values.length), index);
     });
   }
 
+  static Object combine(Object combiner, Object[] values, int offset, int count) {
+    switch (count) {
+      case 2:
+        return ((BiFunction) combiner).apply(values[offset], values[offset + 1]);
+      case 3:
+        return ((Function3) combiner).apply(values[offset], values[offset + 1], values[offset + 2]);
+      case 4:
+        return ((Function4) combiner).apply(values[offset], values[offset + 1], values[offset + 2], values[offset + 3]);
+      default:
+        throw new IllegalArgumentException("Unsupported number of values: " + count);
+    }
+  }
+
+  @SafeVarargs
+  public static <T> Parser<T> alternative(final Parser<? extends T> ...parsers) {
+    return new LLParser<>(Kind.ALTERNATIVE, null, parsers, new ParseFunction() {
+      // Built on first use, when every forward reference below has been bound.
+      Dispatch dispatch;
+
+      @Override
+      public Result apply(CharSequence input, int index, ParseContext context) {
+        Dispatch dispatch = this.dispatch;
+        if (dispatch == null) {
+          dispatch = new Dispatch(parsers);
+          this.dispatch = dispatch;
+        }
+        Dispatch.Route route = dispatch.route(input, index);
+        int[] branches = route.branches;
+        boolean cut = context.cut;
+        Result result = null;
+        for (int i = 0; i < branches.length; ++ i) {
+          if (route.gaps[i] != null) {
+            context.fail(index, route.gaps[i]);
+          }
+          context.cut = false;
+          result = parsers[branches[i]].parse(input, index, context);
+          if (result.status == Status.SUCCESS || context.cut) {
+            context.cut |= cut;
+            return result;
+          }
+        }
+        context.cut = cut;
+        List<String> skipped = route.gaps[branches.length];
+        return skipped == null ? result : context.failure(index, skipped);
+      }
+    });
+  }
+
+  // operand (operator operand)*, folded from the left. The operator's value is the BiFunction that
+  // combines the two sides, so a tree is built in one pass without intermediate lists.
+  public static <T> Parser<T> chainl(Parser<T> operand,
+                                     Parser<? extends BiFunction<? super T, ? super T, ? extends T>> operator) {
+    return new LLParser<>(Kind.CHAIN, Associativity.LEFT, new Parser[] {operand, operator}, (input, index, context) -> {
+      Result result = operand.parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+      Object value = result.value;
+      index = result.index;
+      for (;;) {
+        int failureIndex = context.failureIndex;
+        List<String> failureExpected = context.failureExpected;
+        boolean cut = context.cut;
+        context.cut = false;
+        Result combiner = operator.parse(input, index, context);
+        Result right = combiner.status == Status.SUCCESS ? operand.parse(input, combiner.index, context) : combiner;
+        if (right.status == Status.FAILURE) {
+          if (context.cut) {
+            return right;
+          }
+          context.failureIndex = failureIndex;
+          context.failureExpected = failureExpected;
+          context.cut = cut;
+          return new Result(Status.SUCCESS, value, index);
+        }
+        context.cut |= cut;
+        value = ((BiFunction) combiner.value).apply(value, right.value);
+        index = right.index;
+      }
+    });
+  }
+
+  // operand (operator operand)*, folded from the right.
+  public static <T> Parser<T> chainr(Parser<T> operand,
+                                     Parser<? extends BiFunction<? super T, ? super T, ? extends T>> operator) {
+    return new LLParser<>(Kind.CHAIN, Associativity.RIGHT, new Parser[] {operand, operator}, (input, index, context) -> {
+      Result result = operand.parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+      List<Object> values = new ArrayList<>();
+      List<BiFunction> combiners = new ArrayList<>();
+      values.add(result.value);
+      index = result.index;
+      for (;;) {
+        int failureIndex = context.failureIndex;
+        List<String> failureExpected = context.failureExpected;
+        boolean cut = context.cut;
+        context.cut = false;
+        Result combiner = operator.parse(input, index, context);
+        Result right = combiner.status == Status.SUCCESS ? operand.parse(input, combiner.index, context) : combiner;
+        if (right.status == Status.FAILURE) {
+          if (context.cut) {
+            return right;
+          }
+          context.failureIndex = failureIndex;
+          context.failureExpected = failureExpected;
+          context.cut = cut;
+          break;
+        }
+        context.cut |= cut;
+        combiners.add((BiFunction) combiner.value);
+        values.add(right.value);
+        index = right.index;
+      }
+      Object value = values.get(values.size() - 1);
+      for (int i = combiners.size() - 1; i >= 0; -- i) {
+        value = combiners.get(i).apply(values.get(i), value);
+      }
+      return new Result(Status.SUCCESS, value, index);
+    });
+  }
+
+  // Precedence climbing over operands and the operators of the table. The recursion only goes as
+  // deep as the precedence levels (and right associative runs), not as the number of operators.
+  public static <T> Parser<T> expression(Parser<T> operand, OperatorTable<T> operators) {
+    if (operand == null || operators == null) {
+      throw new IllegalArgumentException("Operand or operators is null.");
+    }
+    OperatorTable.Entry[] infixes = operators.infixes;
+    OperatorTable.Entry[] prefixes = operators.prefixes;
+    ParseFunction<T> action = (input, index, context) ->
+        climb(input, index, context, operand, infixes, prefixes, Integer.MIN_VALUE);
+    return new LLParser<>(Kind.CHAIN, operators, new Parser[] {operand}, action);
+  }
+
+  private static Result climb(CharSequence input, int index, ParseContext context, Parser operand,
+                              OperatorTable.Entry[] infixes, OperatorTable.Entry[] prefixes, int minPrecedence) {
+    Result result = null;
+    for (OperatorTable.Entry prefix : prefixes) {
+      Result operator = prefix.parser.parse(input, index, context);
+      if (operator.status == Status.SUCCESS) {
+        result = climb(input, operator.index, context, operand, infixes, prefixes, prefix.precedence);
+        if (result.status == Status.FAILURE) {
+          return result;
+        }
+        result = new Result(Status.SUCCESS, ((Function) operator.value).apply(result.value), result.index);
+        break;
+      }
+    }
+    if (result == null) {
+      result = operand.parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+    }
+    Object value = result.value;
+    index = result.index;
+    for (;;) {
+      int failureIndex = context.failureIndex;
+      List<String> failureExpected = context.failureExpected;
+      boolean cut = context.cut;
+      context.cut = false;
+      OperatorTable.Entry infix = null;
+      Result operator = null;
+      for (OperatorTable.Entry entry : infixes) {
+        if (entry.precedence < minPrecedence) {
+          continue;
+        }
+        operator = entry.parser.parse(input, index, context);
+        if (operator.status == Status.SUCCESS) {
+          infix = entry;
+          break;
+        }
+      }
+      Result right = operator;
+      if (infix != null) {
+        int next = infix.associativity == OperatorTable.Associativity.LEFT ? infix.precedence + 1 : infix.precedence;
+        right = climb(input, operator.index, context, operand, infixes, prefixes, next);
+      }
+      if (infix == null || right.status == Status.FAILURE) {
+        if (context.cut) {
+          return right;
+        }
+        context.failureIndex = failureIndex;
+        context.failureExpected = failureExpected;
+        context.cut = cut;
+        return new Result(Status.SUCCESS, value, index);
+      }
+      context.cut |= cut;
+      value = ((BiFunction) operator.value).apply(value, right.value);
+      index = right.index;
+    }
+  }
+
+  @Override
+  public Result<T> parse(CharSequence input, int index) {
+    ParseContext context = ParseContext.current();
+    if (context != null) {
+      return parse(input, index, context);
+    }
+    context = ParseContext.open();
+    try {
+      return context.complete(parse(input, index, context));
+    } finally {
+      context.close();
+    }
+  }
+
   @Override
-  public Result parse(String input, int index) {
-    return action.apply(input, index);
+  public Result<T> parse(CharSequence input, int index, ParseContext context) {
+    if (context.profiler != null) {
+      return context.profiler.record(this, input, index, context);
+    }
+    return run(input, index, context);
+  }
+
+  Result<T> run(CharSequence input, int index, ParseContext context) {
+    if (!memoized && !context.packrat) {
+      return action.apply(input, index, context);
+    }
+    MemoTable memo = context.memo;
+    int slot = memo.find(id, index);
+    if (slot >= 0) {
+      context.fail(memo.failureIndex(slot), memo.failureExpected(slot));
+      int extent = memo.extent(slot);
+      if (extent == MemoTable.UNBOUNDED) {
+        context.hitEnd = true;
+      } else if (extent > context.examined) {
+        context.examined = extent;
+      }
+      context.cut |= memo.cut(slot);
+      return memo.result(slot);
+    }
+    int failureIndex = context.failureIndex;
+    List<String> failureExpected = context.failureExpected;
+    int examined = context.examined;
+    boolean hitEnd = context.hitEnd;
+    boolean cut = context.cut;
+    context.failureIndex = -1;
+    context.failureExpected = Collections.emptyList();
+    context.examined = 0;
+    context.hitEnd = false;
+    context.cut = false;
+    Result result = action.apply(input, index, context);
+    // An entry that read up to the end of the input depends on where the input ends, as much as one
+    // that looked past it: text appended there could extend its match.
+    int extent = Math.max(context.examined, result.index);
+    if (context.hitEnd || extent >= input.length()) {
+      extent = MemoTable.UNBOUNDED;
+    }
+    memo.put(id, index, result, context.failureIndex, context.failureExpected, extent, context.cut);
+    int localFailureIndex = context.failureIndex;
+    List<String> localFailureExpected = context.failureExpected;
+    context.failureIndex = failureIndex;
+    context.failureExpected = failureExpected;
+    context.fail(localFailureIndex, localFailureExpected);
+    context.examined = Math.max(examined, context.examined);
+    context.hitEnd |= hitEnd;
+    context.cut |= cut;
+    return result;
   }
 
   @Override
-  public Result parse(String input) {
+  public Result<T> parse(CharSequence input) {
     if (input == null) {
       throw new IllegalArgumentException("The input text is null.");
     }
-    return this.skip(EOF).parse(input, 0);
+    Parser<T> parser = untilEof();
+    ParseContext context = ParseContext.open();
+    try {
+      return context.complete(parser.parse(input, 0, context));
+    } finally {
+      context.close();
+    }
+  }
+
+  // Parses each input like parse(input) and hands the results to the sink in order, all in one
+  // context. Returns the number of inputs that failed. Threads parsing batches get a context each.
+  @Override
+  public int parseAll(Iterable<? extends CharSequence> inputs, Consumer<? super Result<T>> sink) {
+    if (inputs == null || sink == null) {
+      throw new IllegalArgumentException("The inputs or the sink is null.");
+    }
+    Parser<T> parser = untilEof();
+    int failures = 0;
+    ParseContext context = ParseContext.open();
+    try {
+      for (CharSequence input : inputs) {
+        if (input == null) {
+          throw new IllegalArgumentException("The input text is null.");
+        }
+        Result<T> result = context.complete(parser.parse(input, 0, context));
+        context.reset();
+        if (result.status == Status.FAILURE) {
+          ++ failures;
+        }
+        sink.accept(result);
+      }
+    } finally {
+      context.close();
+    }
+    return failures;
+  }
+
+  Parser<T> untilEof() {
+    Parser<T> parser = untilEof;
+    if (parser == null) {
+      parser = this.skip(EOF);
+      untilEof = parser;
+    }
+    return parser;
+  }
+
+  // The parser followed by EOF, built once per LLParser for the entry points that parse all of an input.
+  static <T> Parser<T> untilEof(Parser<T> parser) {
+    return parser instanceof LLParser ? ((LLParser<T>) parser).untilEof() : parser.skip(EOF);
+  }
+
+  // Runs the graph as one Program, which memoizes only the nodes it calls out to: memoize()d ones do
+  // and so, under packrat(), do OPAQUE ones, but everything in between is a single memo entry. Under
+  // packrat(), and so in an IncrementalParser, the interpreted graph runs instead, keeping an entry per
+  // node at the cost of nesting being bounded by the Java stack again.
+  @Override
+  public Parser<T> compile() {
+    Program program = Program.compile(this);
+    return new LLParser<>((input, index, context) ->
+        context.packrat ? parse(input, index, context) : program.run(input, index, context));
+  }
+
+  @Override
+  public Parser<T> memoize() {
+    return new LLParser<>(action, true, kind, operand, children);
+  }
+
+  @Override
+  public Parser<T> packrat() {
+    return new LLParser<>((input, index, context) -> {
+      boolean packrat = context.packrat;
+      context.packrat = true;
+      try {
+        return parse(input, index, context);
+      } finally {
+        context.packrat = packrat;
+      }
+    });
+  }
+
+  // Labels this parser in Profiler reports. Compiled programs only report the nodes they call out to.
+  @Override
+  public Parser<T> named(String name) {
+    if (Utils.isStringNullOrEmpty(name)) {
+      throw new IllegalArgumentException("String is null or empty.");
+    }
+    return new LLParser<>(Kind.NAMED, name, new Parser[] {this},
+        (input, index, context) -> parse(input, index, context));
+  }
+
+  String label() {
+    return kind == Kind.NAMED ? (String) operand : kind.name().toLowerCase() + "#" + id;
   }
 
+  // Once this has succeeded, a later failure no longer backtracks into the alternatives and
+  // repetitions around it.
   @Override
-  public Parser map(Function mapper) {
-    return new LLParser((input, index) -> {
-      Result result = action.apply(input, index);
+  public Parser<T> commit() {
+    return new LLParser<>(Kind.COMMIT, null, new Parser[] {this}, (input, index, context) -> {
+      Result result = parse(input, index, context);
+      if (result.status == Status.SUCCESS) {
+        context.commit(result.index);
+      }
+      return result;
+    });
+  }
+
+  // On a failure, hands the error to the handler and skips to just after the next match of sync at
+  // or past where the error is, or to the end of the input, with the handler's value as the result.
+  // In many() one bad record then costs one handler call instead of the rest of the input. The
+  // error's expectations are only turned into text if the handler reads them.
+  @Override
+  public Parser<T> recover(Parser<?> sync, Function<? super Result<T>, ? extends T> handler) {
+    if (sync == null || handler == null) {
+      throw new IllegalArgumentException("The sync parser or the handler is null.");
+    }
+    return new LLParser<>((input, index, context) -> {
+      int failureIndex = context.failureIndex;
+      List<String> failureExpected = context.failureExpected;
+      boolean cut = context.cut;
+      context.cut = false;
+      context.failureIndex = -1;
+      context.failureExpected = Collections.emptyList();
+      Result<T> result = parse(input, index, context);
+      if (result.status == Status.SUCCESS) {
+        context.cut |= cut;
+        context.fail(failureIndex, failureExpected);
+        return result;
+      }
+      Result<T> error = context.failureIndex < 0
+          ? result
+          : new Result<T>(Status.FAILURE, context.failureIndex, context.failureExpected);
+      int length = input.length();
+      int end = length;
+      for (int i = Math.max(index, error.index); i < length; ++ i) {
+        Result<?> synced = sync.parse(input, i, context);
+        if (synced.status == Status.SUCCESS) {
+          end = synced.index;
+          break;
+        }
+      }
+      if (end == length) {
+        context.hitEnd = true;
+      }
+      context.cut = cut;
+      context.failureIndex = failureIndex;
+      context.failureExpected = failureExpected;
+      if (end == index) {
+        context.fail(error.index, error.expected);
+        return result;
+      }
+      return new Result<T>(Status.SUCCESS, handler.apply(error), end);
+    });
+  }
+
+  @Override
+  public <R> Parser<R> map(Function<? super T, ? extends R> mapper) {
+    return new LLParser<>(Kind.MAP, mapper, new Parser[] {this}, (input, index, context) -> {
+      Result<T> result = parse(input, index, context);
       if (result.status == Status.FAILURE) {
         return result;
       }
-      return new Result(result.status, mapper.apply(result.value), result.index);
+      return new Result<R>(result.status, mapper.apply(result.value), result.index);
     });
   }
 
+  // Adds a node for the value to the Arena of the parse, with the node as an unboxed result.
   @Override
-  public Parser skip(Parser parser) {
-    return sequence(this, parser).map(new Function<List<Object>, Object>() {
-      @Override
-      public Object apply(List<Object> values) {
-        return values.get(0);
+  public IntParser build(Arena.Builder<? super T> builder) {
+    if (builder == null) {
+      throw new IllegalArgumentException("The builder is null.");
+    }
+    return new IntParser(Kind.BUILD, builder, new Parser[] {this}, (input, index, context) -> {
+      Result<T> result = parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return ~result.index;
       }
+      return context.intMatch(builder.build(context.arena(), result.value), result.index);
     });
   }
 
   @Override
-  public Parser then(Parser parser) {
-    return sequence(this, parser).map(new Function<List<Object>, Object>() {
-      @Override
-      public Object apply(List<Object> values) {
-        return values.get(1);
+  public Parser<T> skip(Parser<?> parser) {
+    return new LLParser<>(Kind.SKIP, null, new Parser[] {this, parser}, (input, index, context) -> {
+      Result result = parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return result;
       }
+      Result skipped = parser.parse(input, result.index, context);
+      if (skipped.status == Status.FAILURE) {
+        return skipped;
+      }
+      return new Result(Status.SUCCESS, result.value, skipped.index);
     });
   }
 
   @Override
-  public Parser or(Parser parser) {
+  public <R> Parser<R> then(Parser<R> parser) {
+    return new LLParser<>(Kind.THEN, null, new Parser[] {this, parser}, (input, index, context) -> {
+      Result result = parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+      return parser.parse(input, result.index, context);
+    });
+  }
+
+  @Override
+  public Parser<T> or(Parser<? extends T> parser) {
     return alternative(this, parser);
   }
 
   @Override
-  public Parser times(int num) {
+  public Parser<List<T>> times(int num) {
     return times(num, num);
   }
 
   @Override
-  public Parser times(int min, int max) {
+  public Parser<List<T>> times(int min, int max) {
     if (max < min) {
       throw new IllegalArgumentException("Max is less than min.");
     }
-    return new LLParser((input, index) -> {
+    return new LLParser<>(Kind.TIMES, new int[] {min, max}, new Parser[] {this}, (input, index, context) -> {
       List<Object> values = new ArrayList<>();
-      Result result = null;
       for (int i = 0; i < max; ++ i) {
-        result = merge(result, parse(input, index));
+        int failureIndex = context.failureIndex;
+        List<String> failureExpected = context.failureExpected;
+        boolean cut = context.cut;
+        context.cut = false;
+        Result result = parse(input, index, context);
         if (result.status == Status.FAILURE) {
-          if (i < min) {
+          if (i < min || context.cut) {
+            context.cut |= cut;
             return result;
-          } else {
-            break;
           }
+          // Running out of repetitions is not an error, so forget what the last attempt expected.
+          context.failureIndex = failureIndex;
+          context.failureExpected = failureExpected;
+          context.cut = cut;
+          break;
         }
+        context.cut |= cut;
         values.add(result.value);
         index = result.index;
       }
@@ -188,42 +818,413 @@ public class LLParser implements Parser {
   }
 
   @Override
-  public Parser atLeast(int num) {
+  public Parser<List<T>> atLeast(int num) {
     return times(num, Integer.MAX_VALUE);
   }
 
   @Override
-  public Parser atMost(int num) {
+  public Parser<List<T>> atMost(int num) {
     return times(0, num);
   }
 
   @Override
-  public Parser many() {
-    return new LLParser((input, index) -> {
-      List<Object> values = new ArrayList<>();
-      Result result = null;
-      while (index < input.length()) {
-        result = merge(result, parse(input, index));
-        if (result.status == Status.FAILURE) {
+  public Parser<List<T>> many() {
+    return new LLParser<>(Kind.MANY, null, new Parser[] {this}, (input, index, context) -> {
+      List<T> values = new ArrayList<>();
+      Result<Integer> result = repeat(input, index, context, values::add);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+      return new Result<List<T>>(Status.SUCCESS, values, result.index);
+    });
+  }
+
+  // Like many(), folding the values into one as they are parsed. The same init starts every
+  // parse, so it should not be mutated by the accumulator.
+  @Override
+  public <R> Parser<R> manyFold(R init, BiFunction<? super R, ? super T, ? extends R> accumulator) {
+    return new LLParser<>((input, index, context) -> {
+      Fold<R, T> fold = new Fold<>(init, accumulator);
+      Result<Integer> result = repeat(input, index, context, fold);
+      if (result.status == Status.FAILURE) {
+        return result;
+      }
+      return new Result<R>(Status.SUCCESS, fold.value, result.index);
+    });
+  }
+
+  // Like many(), with the number of repetitions as the value.
+  @Override
+  public Parser<Integer> skipMany() {
+    return new LLParser<>((input, index, context) -> repeat(input, index, context, null));
+  }
+
+  // Like many(), handing every value to the sink as soon as it is parsed, so values of repetitions
+  // that an enclosing parser backtracks over have been handed out all the same. The value is the
+  // number of repetitions.
+  @Override
+  public Parser<Integer> manyInto(Consumer<? super T> sink) {
+    if (sink == null) {
+      throw new IllegalArgumentException("The sink is null.");
+    }
+    return new LLParser<>((input, index, context) -> repeat(input, index, context, sink));
+  }
+
+  // The loop of many(), shared by its variants. Succeeds with the number of repetitions.
+  private Result<Integer> repeat(CharSequence input, int index, ParseContext context, Consumer<? super T> sink) {
+    int count = 0;
+    while (index < input.length()) {
+      int failureIndex = context.failureIndex;
+      List<String> failureExpected = context.failureExpected;
+      boolean cut = context.cut;
+      context.cut = false;
+      Result<T> result = parse(input, index, context);
+      if (result.status == Status.FAILURE) {
+        if (context.cut) {
+          context.cut |= cut;
+          return new Result<>(Status.FAILURE, result.index, result.expected);
+        }
+        context.failureIndex = failureIndex;
+        context.failureExpected = failureExpected;
+        context.cut = cut;
+        break;
+      }
+      context.cut |= cut;
+      if (index == result.index) {
+        throw new RuntimeException("Infinity loop.");
+      }
+      if (sink != null) {
+        sink.accept(result.value);
+      }
+      index = result.index;
+      ++ count;
+    }
+    if (index == input.length()) {
+      context.hitEnd = true;
+    }
+    return new Result<>(Status.SUCCESS, count, index);
+  }
+
+  private static final class Fold<R, T> implements Consumer<T> {
+    private final BiFunction<? super R, ? super T, ? extends R> accumulator;
+    R value;
+
+    Fold(R init, BiFunction<? super R, ? super T, ? extends R> accumulator) {
+      this.value = init;
+      this.accumulator = accumulator;
+    }
+
+    @Override
+    public void accept(T item) {
+      value = accumulator.apply(value, item);
+    }
+  }
+
+  // The rest of the input as records separated by a literal, each parsed on its own in the common
+  // ForkJoinPool. Every record has to be exactly one match of this; a trailing separator is allowed.
+  // The values come back in input order, and a failure is the one in the earliest failing record.
+  // Each record gets a fresh context on its worker thread, packrat like the caller's. Arena and
+  // Profiler are not thread-safe, so a parse through either of them throws IllegalStateException.
+  // The records are read from a String copy of the input, and the whole match counts as having
+  // looked at the end of the input.
+  @Override
+  public Parser<List<T>> parallelMany(String separator) {
+    if (Utils.isStringNullOrEmpty(separator)) {
+      throw new IllegalArgumentException("String is null or empty.");
+    }
+    return new LLParser<>((input, index, context) -> {
+      if (context.arena != null || context.profiler != null) {
+        throw new IllegalStateException("parallelMany() cannot run through an Arena or a Profiler.");
+      }
+      String text = context.string(input);
+      context.hitEnd = true;
+      int[] bounds = new int[16];
+      int size = 0;
+      bounds[size ++] = index;
+      for (int i = index; ; ) {
+        int next = text.indexOf(separator, i);
+        if (next < 0) {
           break;
         }
-        if (index == result.index) {
-          throw new RuntimeException("Infinity loop.");
+        if (size + 2 > bounds.length) {
+          bounds = Arrays.copyOf(bounds, bounds.length << 1);
         }
-        values.add(result.value);
-        index = result.index;
+        bounds[size ++] = next;
+        i = next + separator.length();
+        bounds[size ++] = i;
       }
-      return new Result(Status.SUCCESS, values, index);
+      if (size == bounds.length) {
+        bounds = Arrays.copyOf(bounds, size + 1);
+      }
+      bounds[size ++] = text.length();
+      int records = size / 2;
+      if (records > 1 && bounds[size - 2] == text.length()) {
+        -- records;
+      }
+      if (index == text.length()) {
+        records = 0;
+      }
+      Records task = new Records(untilEof(), context.packrat, text, bounds, 0, records);
+      ForkJoinPool.commonPool().invoke(task);
+      if (task.failure != null) {
+        return context.failure(task.failure.index, task.failure.expected);
+      }
+      return new Result(Status.SUCCESS, Arrays.asList(task.values), text.length());
     });
   }
 
-  public static Parser EOF = new LLParser((input, index) -> {
+  private static final class Records extends RecursiveAction {
+
+    private static final int LEAF_RECORDS = 64;
+
+    private final Parser record;
+    private final boolean packrat;
+    private final String text;
+    // Record i spans [bounds[2i], bounds[2i + 1]).
+    private final int[] bounds;
+    private final int from;
+    private final int to;
+    private final Object[] values;
+    // Records after an already failed one can be skipped.
+    private final AtomicInteger firstFailure;
+    Result failure;
+
+    Records(Parser record, boolean packrat, String text, int[] bounds, int from, int to) {
+      this(record, packrat, text, bounds, from, to, new Object[to - from], new AtomicInteger(Integer.MAX_VALUE));
+    }
+
+    private Records(Parser record, boolean packrat, String text, int[] bounds, int from, int to, Object[] values,
+                    AtomicInteger firstFailure) {
+      this.record = record;
+      this.packrat = packrat;
+      this.text = text;
+      this.bounds = bounds;
+      this.from = from;
+      this.to = to;
+      this.values = values;
+      this.firstFailure = firstFailure;
+    }
+
+    @Override
+    protected void compute() {
+      if (to - from > LEAF_RECORDS) {
+        int middle = (from + to) >>> 1;
+        Records left = new Records(record, packrat, text, bounds, from, middle, values, firstFailure);
+        Records right = new Records(record, packrat, text, bounds, middle, to, values, firstFailure);
+        invokeAll(left, right);
+        failure = left.failure != null ? left.failure : right.failure;
+        return;
+      }
+      for (int i = from; i < to && i < firstFailure.get(); ++ i) {
+        int start = bounds[2 * i];
+        Result result;
+        ParseContext context = ParseContext.open();
+        context.packrat = packrat;
+        try {
+          result = context.complete(record.parse(CharBuffer.wrap(text, start, bounds[2 * i + 1]), 0, context));
+        } finally {
+          context.close();
+        }
+        if (result.status == Status.FAILURE) {
+          failure = new Result(Status.FAILURE, start + result.index, result.expected);
+          firstFailure.accumulateAndGet(i, Math::min);
+          return;
+        }
+        values[i] = result.value;
+      }
+    }
+  }
+
+  private static final List<String> EOF_EXPECTATION = Expected.of("EOF");
+
+  public static Parser<String> EOF = new LLParser<>((input, index, context) -> {
     if (index < input.length()) {
-      return new Result<String>(Status.FAILURE, index, "EOF");
+      return context.failure(index, EOF_EXPECTATION);
     } else {
+      context.hitEnd = true;
       return new Result<String>(Status.SUCCESS, null, index);
     }
   });
-  public static Parser WHITESPACES = LLParser.regex("\\s+");
-  public static Parser OPTIONAL_WHITESPACES = LLParser.regex("\\s*");
+  public static Parser<String> WHITESPACES = LLParser.span(CharClass.WHITESPACE, 1);
+  public static Parser<String> OPTIONAL_WHITESPACES = LLParser.span(CharClass.WHITESPACE, 0);
+  public static Parser<String> DIGITS = LLParser.span(CharClass.DIGIT, 1);
+
+  private static final CharClass IDENTIFIER_START = CharClass.LETTER.or(CharClass.of("_"));
+  private static final List<String> IDENTIFIER_EXPECTATION = Expected.of("identifier");
+
+  public static Parser<String> IDENTIFIER = new LLParser<>(Kind.TERMINAL,
+      new FirstSet(IDENTIFIER_START, IDENTIFIER_EXPECTATION), NO_CHILDREN, (input, index, context) -> {
+    int length = input.length();
+    if (index >= length || !IDENTIFIER_START.contains(input.charAt(index))) {
+      if (index >= length) {
+        context.hitEnd = true;
+      }
+      return context.failure(index, IDENTIFIER_EXPECTATION);
+    }
+    int end = index + 1;
+    while (end < length && CharClass.WORD.contains(input.charAt(end))) {
+      ++ end;
+    }
+    if (end == length) {
+      context.hitEnd = true;
+    }
+    return new Result<String>(Status.SUCCESS, input.subSequence(index, end).toString(), end);
+  });
+
+  private static final List<String> INTEGER_EXPECTATION = Expected.of("integer");
+
+  // An unsigned decimal int, accumulated while scanning. Values that overflow an int do not match.
+  public static IntParser INTEGER = new IntParser(Kind.TERMINAL,
+      new FirstSet(CharClass.DIGIT, INTEGER_EXPECTATION), NO_CHILDREN, (input, index, context) -> {
+    int length = input.length();
+    int end = index;
+    int value = 0;
+    while (end < length && isDigit(input.charAt(end))) {
+      int digit = input.charAt(end) - '0';
+      if (value > (Integer.MAX_VALUE - digit) / 10) {
+        return context.intFailure(index, INTEGER_EXPECTATION);
+      }
+      value = value * 10 + digit;
+      ++ end;
+    }
+    if (end == length) {
+      context.hitEnd = true;
+    }
+    if (end == index) {
+      return context.intFailure(index, INTEGER_EXPECTATION);
+    }
+    return context.intMatch(value, end);
+  });
+
+  private static final List<String> DECIMAL_EXPECTATION = Expected.of("decimal");
+  private static final double[] POWERS_OF_TEN = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+  };
+
+  // digits ('.' digits)? as a Double.
+  public static Parser<Double> DECIMAL = new LLParser<>(Kind.TERMINAL,
+      new FirstSet(CharClass.DIGIT, DECIMAL_EXPECTATION), NO_CHILDREN, (input, index, context) -> {
+    int integerEnd = scanDigits(input, index);
+    if (integerEnd == input.length()) {
+      context.hitEnd = true;
+    }
+    if (integerEnd == index) {
+      return context.failure(index, DECIMAL_EXPECTATION);
+    }
+    int end = integerEnd;
+    if (end + 1 < input.length() && input.charAt(end) == '.' && isDigit(input.charAt(end + 1))) {
+      end = scanDigits(input, end + 1);
+    }
+    // A '.' or a fraction digit may still follow.
+    if (end + 1 >= input.length()) {
+      context.hitEnd = true;
+    }
+    return new Result<Double>(Status.SUCCESS, toDouble(input, index, integerEnd, end), end);
+  });
+
+  private static boolean isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  private static int scanDigits(CharSequence input, int index) {
+    int length = input.length();
+    while (index < length && isDigit(input.charAt(index))) {
+      ++ index;
+    }
+    return index;
+  }
+
+  // With at most 15 significant digits both the mantissa and the power of ten are exact doubles,
+  // so a single division is correctly rounded. Longer literals go through Double.parseDouble.
+  private static double toDouble(CharSequence input, int start, int integerEnd, int end) {
+    int fraction = end > integerEnd ? end - integerEnd - 1 : 0;
+    if (end - start - (fraction > 0 ? 1 : 0) > 15) {
+      return Double.parseDouble(input.subSequence(start, end).toString());
+    }
+    long mantissa = 0;
+    for (int i = start; i < end; ++ i) {
+      char c = input.charAt(i);
+      if (c != '.') {
+        mantissa = mantissa * 10 + (c - '0');
+      }
+    }
+    return mantissa / POWERS_OF_TEN[fraction];
+  }
+
+  boolean isMemoized() {
+    return memoized;
+  }
+
+  Kind kind() {
+    return kind;
+  }
+
+  Object operand() {
+    return operand;
+  }
+
+  Parser[] children() {
+    return children;
+  }
+
+  enum Kind {
+    OPAQUE,
+    TERMINAL,
+    STRING,
+    REGEX,
+    SEQUENCE,
+    ALTERNATIVE,
+    MAP,
+    TIMES,
+    MANY,
+    COMMIT,
+    CHAIN,
+    SKIP,
+    THEN,
+    COMBINE,
+    NAMED,
+    BUILD,
+    REFERENCE
+  }
+
+  static final class Regex {
+    final Pattern pattern;
+    final int group;
+    final List<String> expectation;
+    final FirstSet first;
+
+    private Regex(Pattern pattern, int group, List<String> expectation, FirstSet first) {
+      this.pattern = pattern;
+      this.group = group;
+      this.expectation = expectation;
+      this.first = first;
+    }
+  }
+
+  static final class Reference {
+    private Supplier<? extends Parser> supplier;
+    private volatile Parser parser;
+
+    private Reference(Supplier<? extends Parser> supplier) {
+      this.supplier = supplier;
+    }
+
+    Parser get() {
+      Parser parser = this.parser;
+      if (parser == null) {
+        synchronized (this) {
+          parser = this.parser;
+          if (parser == null) {
+            parser = supplier.get();
+            if (parser == null) {
+              throw new IllegalStateException("The lazy parser is null.");
+            }
+            this.parser = parser;
+            supplier = null;
+          }
+        }
+      }
+      return parser;
+    }
+  }
 }
@@ -0,0 +1,193 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+
+// Splits a text into tokens in a single pass ahead of parsing, so that the parser backtracks over
+// token indexes instead of scanning characters again. At every offset the rule with the longest
+// match wins, the one added first on a tie. Lexers are immutable, every call returns a new one.
+// When every rule is a string() or a regex() in the syntax a DFA supports, the rules are matched
+// all at once by one automaton, and a regex then matches its longest text.
+public final class Lexer {
+
+  private static final class Rule {
+    final String type;
+    final Parser<?> pattern;
+
+    private Rule(String type, Parser<?> pattern) {
+      this.type = type;
+      this.pattern = pattern;
+    }
+  }
+
+  private static final Rule[] NO_RULES = new Rule[0];
+  private static final int INITIAL_CAPACITY = 16;
+  private static final Object IRREGULAR = new Object();
+
+  // A rule's type id is its position. Ignored rules have no type.
+  private final Rule[] rules;
+  // The Dfa of all rules, or IRREGULAR, built on first use.
+  private volatile Object automaton;
+
+  public Lexer() {
+    this(NO_RULES);
+  }
+
+  private Lexer(Rule[] rules) {
+    this.rules = rules;
+  }
+
+  public Lexer rule(String type, Parser<?> pattern) {
+    if (Utils.isStringNullOrEmpty(type)) {
+      throw new IllegalArgumentException("String is null or empty.");
+    }
+    if (typeOf(type) >= 0) {
+      throw new IllegalArgumentException("Duplicate token type: " + type);
+    }
+    return add(new Rule(type, pattern));
+  }
+
+  // Matches like a rule, without producing a token, e.g. for white space and comments.
+  public Lexer ignore(Parser<?> pattern) {
+    return add(new Rule(null, pattern));
+  }
+
+  private Lexer add(Rule rule) {
+    if (rule.pattern == null) {
+      throw new IllegalArgumentException("The pattern is null.");
+    }
+    if (rules.length > Character.MAX_VALUE) {
+      throw new IllegalStateException("Too many rules.");
+    }
+    Rule[] result = Arrays.copyOf(rules, rules.length + 1);
+    result[rules.length] = rule;
+    return new Lexer(result);
+  }
+
+  private int typeOf(String type) {
+    for (int i = 0; i < rules.length; ++ i) {
+      if (type.equals(rules[i].type)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Matches one token of the type in a TokenStream, with the token's text as the value.
+  public Parser<String> token(String type) {
+    int id = Utils.isStringNullOrEmpty(type) ? -1 : typeOf(type);
+    if (id < 0) {
+      throw new IllegalArgumentException("Unknown token type: " + type);
+    }
+    char expectedType = (char) id;
+    List<String> expectation = Expected.of(type);
+    FirstSet first = new FirstSet(CharClass.of(String.valueOf(expectedType)), expectation);
+    return new LLParser<>(LLParser.Kind.TERMINAL, first, LLParser.NO_CHILDREN, (input, index, context) -> {
+      if (index >= input.length()) {
+        context.hitEnd = true;
+      } else if (input.charAt(index) == expectedType) {
+        return new Result<String>(Status.SUCCESS, ((TokenStream) input).text(index), index + 1);
+      }
+      return context.failure(index, expectation);
+    });
+  }
+
+  // A failure is at the first offset no rule matches, with what every rule expected there.
+  public Result<TokenStream> lex(CharSequence text) {
+    if (text == null) {
+      throw new IllegalArgumentException("The input text is null.");
+    }
+    char[] types = new char[INITIAL_CAPACITY];
+    int[] starts = new int[INITIAL_CAPACITY];
+    int[] ends = new int[INITIAL_CAPACITY];
+    int count = 0;
+    Dfa dfa = automaton();
+    ParseContext context = ParseContext.open();
+    try {
+      int length = text.length();
+      for (int index = 0; index < length; ) {
+        // Failures while lexing earlier tokens say nothing about this offset.
+        context.failureIndex = -1;
+        context.failureExpected = Collections.emptyList();
+        int rule = -1;
+        int end = index;
+        if (dfa != null) {
+          long match = dfa.match(text, index, context);
+          if (match >= 0 && (int) match > index) {
+            rule = (int) (match >>> 32);
+            end = (int) match;
+          }
+        } else {
+          for (int i = 0; i < rules.length; ++ i) {
+            Result<?> result = rules[i].pattern.parse(text, index, context);
+            // Empty matches never win, they would not move the lexer on.
+            if (result.status == Status.SUCCESS && result.index > end) {
+              rule = i;
+              end = result.index;
+            }
+          }
+        }
+        if (rule < 0) {
+          if (dfa != null) {
+            // The automaton records no failures, so every rule expected something here.
+            context.fail(index, expectation());
+          }
+          return context.complete(new Result<>(Status.FAILURE, index, Collections.<String>emptyList()));
+        }
+        if (rules[rule].type != null) {
+          if (count == types.length) {
+            types = Arrays.copyOf(types, count << 1);
+            starts = Arrays.copyOf(starts, count << 1);
+            ends = Arrays.copyOf(ends, count << 1);
+          }
+          types[count] = (char) rule;
+          starts[count] = index;
+          ends[count] = end;
+          ++ count;
+        }
+        index = end;
+      }
+    } finally {
+      context.close();
+    }
+    return Result.success(new TokenStream(text, types, starts, ends, count), text.length());
+  }
+
+  private Dfa automaton() {
+    Object automaton = this.automaton;
+    if (automaton == null) {
+      Parser<?>[] patterns = new Parser<?>[rules.length];
+      for (int i = 0; i < rules.length; ++ i) {
+        patterns[i] = rules[i].pattern;
+      }
+      Dfa dfa = rules.length == 0 ? null : Dfa.compile(patterns);
+      automaton = dfa == null ? IRREGULAR : dfa;
+      this.automaton = automaton;
+    }
+    return automaton == IRREGULAR ? null : (Dfa) automaton;
+  }
+
+  // Only called with the automaton, so every rule is a string() or a regex().
+  private List<String> expectation() {
+    List<String> expectation = Collections.emptyList();
+    for (Rule rule : rules) {
+      LLParser<?> pattern = (LLParser<?>) rule.pattern;
+      expectation = Expected.union(expectation, pattern.kind() == LLParser.Kind.STRING
+          ? Expected.of((String) pattern.operand())
+          : ((LLParser.Regex) pattern.operand()).expectation);
+    }
+    return expectation;
+  }
+
+  // Lexes the text and parses all of its tokens. Indexes in the result are offsets in the text.
+  public <T> Result<T> parse(Parser<T> parser, CharSequence text) {
+    Result<TokenStream> lexed = lex(text);
+    if (lexed.status == Status.FAILURE) {
+      return new Result<>(Status.FAILURE, lexed.index, lexed.expected);
+    }
+    TokenStream tokens = lexed.value;
+    Result<T> result = parser.parse(tokens);
+    return new Result<>(result.status, result.value, tokens.offset(result.index), result.expected);
+  }
+}
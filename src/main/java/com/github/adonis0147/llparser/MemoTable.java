@@ -0,0 +1,271 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+import java.util.List;
+
+// Open addressing memo entries keyed by parser id and index. After an edit of the input, entries are
+// not moved: each one keeps the version of the text its index belongs to, and a lookup maps the
+// index back through the last MAX_EDITS edits, moving an entry that is still valid on the way.
+final class MemoTable {
+
+  private static final int INITIAL_CAPACITY = 1 << 8;
+  private static final int MAXIMUM_CAPACITY = 1 << 20;
+  private static final int MAX_PROBES = 8;
+  // The extent of an entry that looked at the end of the input.
+  static final int UNBOUNDED = Integer.MAX_VALUE;
+  // Entries older than this many edits are dropped instead of moved.
+  private static final int MAX_EDITS = 8;
+
+  private long[] keys;
+  private Result[] results;
+  private int[] failureIndexes;
+  private Object[] failureExpectations;
+  private int[] extents;
+  private boolean[] cuts;
+  private int[] stamps;
+  private int[] versions;
+  private int generation = 1;
+  // The number of edits so far, and the version of the oldest entries that can still be moved.
+  private int version;
+  private int oldest;
+  // Edit v, in the text of version v - 1, is at v & (MAX_EDITS - 1).
+  private final int[] editOffsets = new int[MAX_EDITS];
+  private final int[] editRemoved = new int[MAX_EDITS];
+  private final int[] editInserted = new int[MAX_EDITS];
+  private int size;
+  // Entries below the floor can never be asked for again and are reused like free slots.
+  private int floor;
+
+  MemoTable() {
+    allocate(INITIAL_CAPACITY);
+  }
+
+  int find(int id, int index) {
+    if (index < floor) {
+      return -1;
+    }
+    int slot = probe(id, index, version);
+    // Walks back through the edits: the index the entry would have had before edit v.
+    int original = index;
+    for (int v = version; slot < 0 && v > oldest; -- v) {
+      int edit = v & (MAX_EDITS - 1);
+      int offset = editOffsets[edit];
+      int inserted = editInserted[edit];
+      if (original >= offset + inserted) {
+        original -= inserted - editRemoved[edit];
+      } else if (original > offset) {
+        // Inside the inserted text: nothing from before the edit starts there.
+        return -1;
+      }
+      slot = probe(id, original, v - 1);
+      if (slot >= 0) {
+        return move(slot, id, index, v);
+      }
+    }
+    return slot;
+  }
+
+  Result result(int slot) {
+    return results[slot];
+  }
+
+  int failureIndex(int slot) {
+    return failureIndexes[slot];
+  }
+
+  @SuppressWarnings("unchecked")
+  List<String> failureExpected(int slot) {
+    return (List<String>) failureExpectations[slot];
+  }
+
+  int extent(int slot) {
+    return extents[slot];
+  }
+
+  boolean cut(int slot) {
+    return cuts[slot];
+  }
+
+  // failureIndex and failureExpected are the farthest failure seen while the entry was computed, and
+  // cut whether it passed a commit(), so that a hit can replay them into the parse context. extent is
+  // one past the last character the entry depends on.
+  void put(int id, int index, Result result, int failureIndex, List<String> failureExpected, int extent,
+           boolean cut) {
+    if (index < floor) {
+      return;
+    }
+    if (size >= (keys.length >> 1) && keys.length < MAXIMUM_CAPACITY) {
+      resize();
+    }
+    insert(key(id, index), result, failureIndex, failureExpected, extent, cut, version);
+  }
+
+  // Records an edit of the input in O(1). The entries it cannot have changed, those that depend only
+  // on what comes before it and those that start after it, are moved when they are next found.
+  void edit(int offset, int removed, int inserted) {
+    int edit = ++ version & (MAX_EDITS - 1);
+    editOffsets[edit] = offset;
+    editRemoved[edit] = removed;
+    editInserted[edit] = inserted;
+    if (version - oldest > MAX_EDITS) {
+      oldest = version - MAX_EDITS;
+    }
+    floor = 0;
+  }
+
+  private int probe(int id, int index, int version) {
+    long key = key(id, index);
+    int mask = keys.length - 1;
+    int slot = hash(key) & mask;
+    for (int probe = 0; probe < MAX_PROBES; ++ probe, slot = (slot + 1) & mask) {
+      if (stamps[slot] != generation) {
+        return -1;
+      }
+      if (keys[slot] == key && versions[slot] == version) {
+        return slot;
+      }
+    }
+    return -1;
+  }
+
+  // Replays edits from..version on the entry in slot, made before edit from, and stores it again at
+  // index if it survives all of them.
+  private int move(int slot, int id, int index, int from) {
+    int start = (int) keys[slot];
+    int extent = extents[slot];
+    for (int v = from; v <= version; ++ v) {
+      int edit = v & (MAX_EDITS - 1);
+      int offset = editOffsets[edit];
+      if (extent <= offset) {
+        continue;
+      }
+      if (start < offset + editRemoved[edit]) {
+        return -1;
+      }
+      int delta = editInserted[edit] - editRemoved[edit];
+      start += delta;
+      extent = extent == UNBOUNDED ? UNBOUNDED : extent + delta;
+    }
+    if (start != index) {
+      return -1;
+    }
+    int delta = index - (int) keys[slot];
+    Result result = results[slot];
+    int failureIndex = failureIndexes[slot];
+    if (delta != 0) {
+      result = new Result(result.status, result.value, result.index + delta, result.expected);
+      failureIndex = failureIndex < 0 ? failureIndex : failureIndex + delta;
+    }
+    Object failureExpected = failureExpectations[slot];
+    boolean cut = cuts[slot];
+    if (size >= (keys.length >> 1) && keys.length < MAXIMUM_CAPACITY) {
+      resize();
+    }
+    return insert(key(id, index), result, failureIndex, failureExpected, extent, cut, version);
+  }
+
+  // Entries below the floor are as good as ever once a new parse starts over.
+  void resetFloor() {
+    floor = 0;
+  }
+
+  void cut(int index) {
+    if (index > floor) {
+      floor = index;
+    }
+  }
+
+  // Starts a new parse. Stale entries are invalidated by the generation stamp instead of being cleared.
+  void clear() {
+    size = 0;
+    floor = 0;
+    oldest = version;
+    if (++ generation == 0) {
+      Arrays.fill(stamps, 0);
+      generation = 1;
+    }
+  }
+
+  private int insert(long key, Result result, int failureIndex, Object failureExpected, int extent, boolean cut,
+                     int version) {
+    int mask = keys.length - 1;
+    int home = hash(key) & mask;
+    int slot = home;
+    int probe = 0;
+    while (probe < MAX_PROBES && isLive(slot) && keys[slot] != key) {
+      slot = (slot + 1) & mask;
+      ++ probe;
+    }
+    if (probe == MAX_PROBES) {
+      // Keeps the table bounded: a crowded neighbourhood evicts its home entry.
+      slot = home;
+    } else if (stamps[slot] != generation) {
+      stamps[slot] = generation;
+      ++ size;
+    }
+    keys[slot] = key;
+    results[slot] = result;
+    failureIndexes[slot] = failureIndex;
+    failureExpectations[slot] = failureExpected;
+    extents[slot] = extent;
+    cuts[slot] = cut;
+    versions[slot] = version;
+    return slot;
+  }
+
+  // Entries of the current version below the floor are dead, and so are entries too old to be moved.
+  private boolean isLive(int slot) {
+    if (stamps[slot] != generation) {
+      return false;
+    }
+    return versions[slot] == version ? (int) keys[slot] >= floor : versions[slot] >= oldest;
+  }
+
+  private void resize() {
+    long[] oldKeys = keys;
+    Result[] oldResults = results;
+    int[] oldFailureIndexes = failureIndexes;
+    Object[] oldFailureExpectations = failureExpectations;
+    int[] oldExtents = extents;
+    boolean[] oldCuts = cuts;
+    int[] oldVersions = versions;
+    boolean[] live = new boolean[oldKeys.length];
+    int count = 0;
+    for (int i = 0; i < oldKeys.length; ++ i) {
+      if (isLive(i)) {
+        live[i] = true;
+        ++ count;
+      }
+    }
+    // After a cut most entries may be dead, in which case rehashing in place is enough.
+    allocate(count < (oldKeys.length >> 2) ? oldKeys.length : oldKeys.length << 1);
+    for (int i = 0; i < oldKeys.length; ++ i) {
+      if (live[i]) {
+        insert(oldKeys[i], oldResults[i], oldFailureIndexes[i], oldFailureExpectations[i], oldExtents[i], oldCuts[i],
+            oldVersions[i]);
+      }
+    }
+  }
+
+  private void allocate(int capacity) {
+    keys = new long[capacity];
+    results = new Result[capacity];
+    failureIndexes = new int[capacity];
+    failureExpectations = new Object[capacity];
+    extents = new int[capacity];
+    cuts = new boolean[capacity];
+    stamps = new int[capacity];
+    versions = new int[capacity];
+    generation = 1;
+    size = 0;
+  }
+
+  private static long key(int id, int index) {
+    return ((long) id << 32) | (index & 0xffffffffL);
+  }
+
+  private static int hash(long key) {
+    long h = key * 0x9E3779B97F4A7C15L;
+    return (int) (h ^ (h >>> 32));
+  }
+}
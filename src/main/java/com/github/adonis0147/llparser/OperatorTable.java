@@ -0,0 +1,63 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+import java.util.function.BiFunction;
+import java.util.function.Function;
+
+// The operators of LLParser.expression(). A higher precedence binds tighter. An infix operator's
+// parser yields the BiFunction that combines both sides, a prefix operator's yields a Function.
+// Operators are tried in the order they were added. Tables are immutable, every call returns a new one.
+public final class OperatorTable<T> {
+
+  public enum Associativity {
+    LEFT,
+    RIGHT
+  }
+
+  static final class Entry {
+    final Parser parser;
+    final int precedence;
+    final Associativity associativity;
+
+    private Entry(Parser parser, int precedence, Associativity associativity) {
+      this.parser = parser;
+      this.precedence = precedence;
+      this.associativity = associativity;
+    }
+  }
+
+  private static final Entry[] NO_ENTRIES = new Entry[0];
+
+  final Entry[] infixes;
+  final Entry[] prefixes;
+
+  public OperatorTable() {
+    this(NO_ENTRIES, NO_ENTRIES);
+  }
+
+  private OperatorTable(Entry[] infixes, Entry[] prefixes) {
+    this.infixes = infixes;
+    this.prefixes = prefixes;
+  }
+
+  public OperatorTable<T> infix(Parser<? extends BiFunction<? super T, ? super T, ? extends T>> operator,
+                                int precedence, Associativity associativity) {
+    if (operator == null || associativity == null) {
+      throw new IllegalArgumentException("Operator or associativity is null.");
+    }
+    return new OperatorTable<>(add(infixes, new Entry(operator, precedence, associativity)), prefixes);
+  }
+
+  public OperatorTable<T> prefix(Parser<? extends Function<? super T, ? extends T>> operator, int precedence) {
+    if (operator == null) {
+      throw new IllegalArgumentException("Operator is null.");
+    }
+    return new OperatorTable<>(infixes, add(prefixes, new Entry(operator, precedence, Associativity.RIGHT)));
+  }
+
+  private static Entry[] add(Entry[] entries, Entry entry) {
+    Entry[] result = Arrays.copyOf(entries, entries.length + 1);
+    result[entries.length] = entry;
+    return result;
+  }
+}
@@ -0,0 +1,229 @@
+package com.github.adonis0147.llparser;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+public final class ParseContext {
+
+  private static final ThreadLocal<ParseContext> CURRENT = new ThreadLocal<>();
+  private static final ThreadLocal<ParseContext> SPARE = ThreadLocal.withInitial(ParseContext::new);
+  private static final int MAX_CACHED_MATCHERS = 1 << 12;
+
+  final MemoTable memo = new MemoTable();
+  boolean packrat;
+
+  // The farthest failure of the parse so far and everything that was expected there.
+  int failureIndex = -1;
+  List<String> failureExpected = Collections.emptyList();
+
+  // Set once the current branch has passed a commit(). Choice points save and reset it around every
+  // branch and do not try another branch after a failure with it set.
+  boolean cut;
+
+  // Set once anything looked at or past the end of the input, i.e. more input could change the outcome.
+  boolean hitEnd;
+
+  // One past the largest index read through a TrackedInput. Only an IncrementalParser reads that way.
+  int examined;
+
+  // The value of the last IntParser match, handed over without boxing.
+  int intValue;
+
+  // Set while a Profiler runs. Every LLParser checks it once per call.
+  Profiler profiler;
+
+  // Set while an Arena runs, for the nodes of Parser.build() and IntParser.chainl(operator, combiner).
+  Arena arena;
+
+  // One reusable Matcher per regex() pattern, each pattern belonging to one parser. The cache is
+  // dropped as a whole once it outgrows MAX_CACHED_MATCHERS, so discarded grammars are not kept alive.
+  private final Map<Pattern, BoundMatcher> matchers = new IdentityHashMap<>();
+  // The matchers bound to an input during this parse.
+  private final List<BoundMatcher> bound = new ArrayList<>();
+
+  // The String view of a non-String input, made once per parse for BiFunction based parsers.
+  private CharSequence copiedInput;
+  private String copy;
+
+  private ParseContext previous;
+  private boolean inUse;
+
+  ParseContext() {
+  }
+
+  static ParseContext current() {
+    return CURRENT.get();
+  }
+
+  // Every thread keeps one context around so the memo table is reused across top-level parses.
+  static ParseContext open() {
+    ParseContext context = SPARE.get();
+    if (context.inUse) {
+      context = new ParseContext();
+    }
+    return context.enter();
+  }
+
+  void close() {
+    memo.clear();
+    leave();
+  }
+
+  // Makes this the current context without touching its memo table.
+  ParseContext enter() {
+    inUse = true;
+    previous = CURRENT.get();
+    CURRENT.set(this);
+    return this;
+  }
+
+  // Forgets the last of a batch of top-level parses, keeping the context current for the next one.
+  void reset() {
+    memo.clear();
+    cut = false;
+    hitEnd = false;
+    examined = 0;
+    failureIndex = -1;
+    failureExpected = Collections.emptyList();
+  }
+
+  void leave() {
+    releaseMatchers();
+    copiedInput = null;
+    copy = null;
+    packrat = false;
+    cut = false;
+    hitEnd = false;
+    examined = 0;
+    profiler = null;
+    arena = null;
+    failureIndex = -1;
+    failureExpected = Collections.emptyList();
+    if (previous == null) {
+      CURRENT.remove();
+    } else {
+      CURRENT.set(previous);
+    }
+    previous = null;
+    inUse = false;
+  }
+
+  Matcher matcher(Pattern pattern, CharSequence input) {
+    BoundMatcher entry = matchers.get(pattern);
+    if (entry == null) {
+      entry = new BoundMatcher(pattern.matcher(input).useTransparentBounds(true));
+      matchers.put(pattern, entry);
+    } else if (entry.input == input) {
+      return entry.matcher;
+    } else {
+      entry.matcher.reset(input);
+    }
+    if (entry.input == null) {
+      bound.add(entry);
+    }
+    entry.input = input;
+    return entry.matcher;
+  }
+
+  // Drops the references to the input so an idle context does not pin the last document.
+  private void releaseMatchers() {
+    for (BoundMatcher entry : bound) {
+      entry.matcher.reset("");
+      entry.input = null;
+    }
+    bound.clear();
+    if (matchers.size() > MAX_CACHED_MATCHERS) {
+      matchers.clear();
+    }
+  }
+
+  private static final class BoundMatcher {
+    final Matcher matcher;
+    CharSequence input;
+
+    BoundMatcher(Matcher matcher) {
+      this.matcher = matcher;
+    }
+  }
+
+  // Nothing can backtrack to before index any more, so the memo entries there are dead.
+  void commit(int index) {
+    cut = true;
+    memo.cut(index);
+  }
+
+  String string(CharSequence input) {
+    if (input instanceof String) {
+      return (String) input;
+    }
+    if (copiedInput != input) {
+      copy = input.toString();
+      copiedInput = input;
+    }
+    return copy;
+  }
+
+  void fail(int index, List<String> expected) {
+    if (index > failureIndex) {
+      failureIndex = index;
+      failureExpected = expected;
+    } else if (index == failureIndex) {
+      failureExpected = Expected.union(failureExpected, expected);
+    }
+  }
+
+  // Custom parsers call this when they look at or past the end of the input, so that a StreamParser
+  // reads more before it trusts their result.
+  public void hitEnd() {
+    hitEnd = true;
+  }
+
+  public <T> Result<T> failure(int index, String expected) {
+    return failure(index, Expected.of(expected));
+  }
+
+  <T> Result<T> failure(int index, List<String> expected) {
+    fail(index, expected);
+    return new Result<>(Status.FAILURE, index, expected);
+  }
+
+  Arena arena() {
+    if (arena == null) {
+      throw new IllegalStateException("Nodes are only built in a parse run through an Arena.");
+    }
+    return arena;
+  }
+
+  // What an IntParseFunction returns on success: the end of the match, with the value kept here.
+  public int intMatch(int value, int end) {
+    intValue = value;
+    return end;
+  }
+
+  public int intValue() {
+    return intValue;
+  }
+
+  // What an IntParseFunction returns on failure.
+  public int intFailure(int index, String expected) {
+    return intFailure(index, Expected.of(expected));
+  }
+
+  int intFailure(int index, List<String> expected) {
+    fail(index, expected);
+    return ~index;
+  }
+
+  // Turns the outcome of a top-level parse into the single error the caller sees.
+  <T> Result<T> complete(Result<T> result) {
+    if (result.status == Status.SUCCESS || failureIndex < 0) {
+      return result;
+    }
+    return new Result<>(Status.FAILURE, failureIndex, failureExpected);
+  }
+}
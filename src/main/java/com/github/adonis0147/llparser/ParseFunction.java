@@ -0,0 +1,8 @@
+package com.github.adonis0147.llparser;
+
+// The core contract of LLParser. The index is a plain int, and context carries the per-parse state
+// that has to be handed on to every child parser.
+@FunctionalInterface
+public interface ParseFunction<T> {
+  Result<T> apply(CharSequence input, int index, ParseContext context);
+}
@@ -1,28 +1,57 @@
 package com.github.adonis0147.llparser;
 
+import java.util.List;
+import java.util.function.BiFunction;
+import java.util.function.Consumer;
 import java.util.function.Function;
 
-public interface Parser {
+public interface Parser<T> {
 
-  Result parse(String input, int index);
+  Result<T> parse(CharSequence input, int index);
 
-  Result parse(String input);
+  Result<T> parse(CharSequence input, int index, ParseContext context);
 
-  Parser map(Function function);
+  Result<T> parse(CharSequence input);
 
-  Parser skip(Parser parser);
+  int parseAll(Iterable<? extends CharSequence> inputs, Consumer<? super Result<T>> sink);
 
-  Parser then(Parser parser);
+  Parser<T> compile();
 
-  Parser or(Parser parser);
+  Parser<T> memoize();
 
-  Parser times(int num);
+  Parser<T> packrat();
 
-  Parser times(int min, int max);
+  Parser<T> commit();
 
-  Parser atLeast(int num);
+  Parser<T> named(String name);
 
-  Parser atMost(int num);
+  Parser<T> recover(Parser<?> sync, Function<? super Result<T>, ? extends T> handler);
 
-  Parser many();
+  <R> Parser<R> map(Function<? super T, ? extends R> function);
+
+  IntParser build(Arena.Builder<? super T> builder);
+
+  Parser<T> skip(Parser<?> parser);
+
+  <R> Parser<R> then(Parser<R> parser);
+
+  Parser<T> or(Parser<? extends T> parser);
+
+  Parser<List<T>> times(int num);
+
+  Parser<List<T>> times(int min, int max);
+
+  Parser<List<T>> atLeast(int num);
+
+  Parser<List<T>> atMost(int num);
+
+  Parser<List<T>> many();
+
+  <R> Parser<R> manyFold(R init, BiFunction<? super R, ? super T, ? extends R> accumulator);
+
+  Parser<Integer> skipMany();
+
+  Parser<Integer> manyInto(Consumer<? super T> sink);
+
+  Parser<List<T>> parallelMany(String separator);
 }
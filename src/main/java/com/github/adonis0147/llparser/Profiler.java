@@ -0,0 +1,121 @@
+package com.github.adonis0147.llparser;
+
+import java.util.ArrayList;
+import java.util.IdentityHashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+// Counts what every parser node does during the parses run through it. Rules are labeled by
+// named(), other nodes by their kind and id. Parses that do not go through a Profiler only pay for
+// one null check per call. A Profiler is not thread-safe.
+public final class Profiler {
+
+  public static final class Stats {
+    long invocations;
+    long successes;
+    long failures;
+    long consumed;
+    long backtracked;
+    long nanos;
+
+    public long invocations() {
+      return invocations;
+    }
+
+    public long successes() {
+      return successes;
+    }
+
+    public long failures() {
+      return failures;
+    }
+
+    // Characters matched by the successful calls.
+    public long consumed() {
+      return consumed;
+    }
+
+    // How far the failed calls got before they failed, i.e. what is scanned again by whatever comes next.
+    public long backtracked() {
+      return backtracked;
+    }
+
+    // Including the time spent in nested nodes.
+    public long nanos() {
+      return nanos;
+    }
+
+    private void add(Stats stats) {
+      invocations += stats.invocations;
+      successes += stats.successes;
+      failures += stats.failures;
+      consumed += stats.consumed;
+      backtracked += stats.backtracked;
+      nanos += stats.nanos;
+    }
+  }
+
+  private final Map<LLParser<?>, Stats> nodes = new IdentityHashMap<>();
+
+  public <T> Result<T> parse(Parser<T> parser, CharSequence input) {
+    if (input == null) {
+      throw new IllegalArgumentException("The input text is null.");
+    }
+    Parser<T> untilEof = LLParser.untilEof(parser);
+    ParseContext context = ParseContext.open();
+    context.profiler = this;
+    try {
+      return context.complete(untilEof.parse(input, 0, context));
+    } finally {
+      context.close();
+    }
+  }
+
+  <T> Result<T> record(LLParser<T> parser, CharSequence input, int index, ParseContext context) {
+    Stats stats = nodes.get(parser);
+    if (stats == null) {
+      stats = new Stats();
+      nodes.put(parser, stats);
+    }
+    long start = System.nanoTime();
+    Result<T> result = parser.run(input, index, context);
+    stats.nanos += System.nanoTime() - start;
+    ++ stats.invocations;
+    if (result.status == Status.SUCCESS) {
+      ++ stats.successes;
+      stats.consumed += result.index - index;
+    } else {
+      ++ stats.failures;
+      stats.backtracked += result.index - index;
+    }
+    return result;
+  }
+
+  // The statistics per label, nodes sharing a label are added up.
+  public Map<String, Stats> stats() {
+    Map<String, Stats> stats = new LinkedHashMap<>();
+    for (Map.Entry<LLParser<?>, Stats> entry : nodes.entrySet()) {
+      stats.computeIfAbsent(entry.getKey().label(), label -> new Stats()).add(entry.getValue());
+    }
+    return stats;
+  }
+
+  // One line per label, the most expensive first.
+  public String report() {
+    List<Map.Entry<String, Stats>> rows = new ArrayList<>(stats().entrySet());
+    rows.sort((lhs, rhs) -> Long.compare(rhs.getValue().nanos, lhs.getValue().nanos));
+    StringBuilder builder = new StringBuilder(String.format("%-24s %10s %10s %10s %10s %12s %10s%n",
+        "rule", "calls", "successes", "failures", "consumed", "backtracked", "time (ms)"));
+    for (Map.Entry<String, Stats> row : rows) {
+      Stats stats = row.getValue();
+      builder.append(String.format("%-24s %10d %10d %10d %10d %12d %10.3f%n", row.getKey(), stats.invocations,
+          stats.successes, stats.failures, stats.consumed, stats.backtracked, stats.nanos / 1e6));
+    }
+    return builder.toString();
+  }
+
+  public void reset() {
+    nodes.clear();
+  }
+}
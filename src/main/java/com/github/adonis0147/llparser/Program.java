@@ -0,0 +1,639 @@
+package com.github.adonis0147.llparser;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.IdentityHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.function.BiFunction;
+import java.util.function.Function;
+
+// A parser graph lowered into a flat instruction array and run by a backtracking stack machine.
+// Every compiled node leaves exactly one value on the value stack when it succeeds; a failure
+// unwinds to the most recent choice point. OPAQUE and memoized nodes are called through LEAF, the
+// only memo boundaries a program has.
+// Forward references, chain operands, the right hand sides of chainr() and the precedence levels of
+// expression() become subroutines, so recursion uses the heap allocated return stack and nesting
+// depth is bounded by memory only. Parser.build() and IntParser.chainl() add their Arena nodes here.
+final class Program {
+
+  private static final int HALT = 0;
+  private static final int LEAF = 1;          // parser
+  private static final int STRING = 2;        // literal, expectation
+  private static final int LIST = 3;          // count
+  private static final int APPLY = 4;         // function
+  private static final int CHOICE = 5;        // handler
+  private static final int COMMIT = 6;        // target
+  private static final int NEW_LIST = 7;
+  private static final int APPEND = 8;
+  private static final int TIMES_TEST = 9;    // max, exit
+  private static final int TIMES_END = 10;    // min
+  private static final int MANY_TEST = 11;    // exit
+  private static final int MANY_APPEND = 12;
+  private static final int ROLLBACK = 13;
+  private static final int CALL = 14;         // subroutine
+  private static final int RET = 15;
+  private static final int CUT = 16;
+  private static final int DROP = 17;
+  private static final int NIP = 18;
+  private static final int COMBINE = 19;      // count, function
+  private static final int FOLD = 20;
+  private static final int JUMP = 21;         // target
+  private static final int UNARY = 22;
+  private static final int NODE = 23;         // combiner
+  private static final int BUILD = 24;        // builder
+
+  // A choice point is (handler, index, value stack size, return stack size, failure index, cut) plus
+  // the failure expectations.
+  private static final int CHOICE_SIZE = 6;
+
+  private final int[] code;
+  private final Object[] constants;
+
+  private Program(int[] code, Object[] constants) {
+    this.code = code;
+    this.constants = constants;
+  }
+
+  static Program compile(LLParser parser) {
+    Compiler compiler = new Compiler(parser);
+    compiler.emit(parser);
+    compiler.emit(HALT);
+    compiler.emitSubroutines();
+    return new Program(Arrays.copyOf(compiler.code, compiler.size), compiler.constants.toArray());
+  }
+
+  @SuppressWarnings("unchecked")
+  Result run(CharSequence input, int index, ParseContext context) {
+    int[] code = this.code;
+    Object[] constants = this.constants;
+    Object[] values = new Object[16];
+    int vsp = 0;
+    int[] choices = new int[CHOICE_SIZE * 8];
+    Object[] choiceExpectations = new Object[8];
+    int csp = 0;
+    int[] returns = new int[16];
+    int rsp = 0;
+    int markIndex = -1;
+    List<String> markExpected = null;
+    Result failure = null;
+    int pc = 0;
+    for (;;) {
+      switch (code[pc]) {
+        case HALT:
+          return new Result(Status.SUCCESS, values[vsp - 1], index);
+        case LEAF: {
+          Result result = ((Parser) constants[code[pc + 1]]).parse(input, index, context);
+          if (result.status == Status.SUCCESS) {
+            if (vsp == values.length) {
+              values = Arrays.copyOf(values, vsp << 1);
+            }
+            values[vsp ++] = result.value;
+            index = result.index;
+            pc += 2;
+            continue;
+          }
+          failure = result;
+          break;
+        }
+        case STRING: {
+          String literal = (String) constants[code[pc + 1]];
+          if (Utils.regionMatches(input, index, literal)) {
+            if (vsp == values.length) {
+              values = Arrays.copyOf(values, vsp << 1);
+            }
+            values[vsp ++] = literal;
+            index += literal.length();
+            pc += 3;
+            continue;
+          }
+          if (index + literal.length() > input.length()) {
+            context.hitEnd = true;
+          }
+          failure = context.failure(index, (List<String>) constants[code[pc + 2]]);
+          break;
+        }
+        case LIST: {
+          int count = code[pc + 1];
+          List<Object> list = new ArrayList<>(count);
+          for (int i = vsp - count; i < vsp; ++ i) {
+            list.add(values[i]);
+          }
+          vsp -= count;
+          if (vsp == values.length) {
+            values = Arrays.copyOf(values, vsp << 1);
+          }
+          values[vsp ++] = list;
+          pc += 2;
+          continue;
+        }
+        case APPLY:
+          values[vsp - 1] = ((Function) constants[code[pc + 1]]).apply(values[vsp - 1]);
+          pc += 2;
+          continue;
+        case CHOICE: {
+          if (csp == choiceExpectations.length) {
+            choices = Arrays.copyOf(choices, choices.length << 1);
+            choiceExpectations = Arrays.copyOf(choiceExpectations, csp << 1);
+          }
+          int base = csp * CHOICE_SIZE;
+          choices[base] = code[pc + 1];
+          choices[base + 1] = index;
+          choices[base + 2] = vsp;
+          choices[base + 3] = rsp;
+          choices[base + 4] = context.failureIndex;
+          choices[base + 5] = context.cut ? 1 : 0;
+          choiceExpectations[csp ++] = context.failureExpected;
+          context.cut = false;
+          pc += 2;
+          continue;
+        }
+        case COMMIT:
+          if (choices[-- csp * CHOICE_SIZE + 5] != 0) {
+            context.cut = true;
+          }
+          pc = code[pc + 1];
+          continue;
+        case NEW_LIST:
+          if (vsp == values.length) {
+            values = Arrays.copyOf(values, vsp << 1);
+          }
+          values[vsp ++] = new ArrayList<>();
+          pc += 1;
+          continue;
+        case APPEND: {
+          Object value = values[-- vsp];
+          ((List<Object>) values[vsp - 1]).add(value);
+          pc += 1;
+          continue;
+        }
+        case TIMES_TEST:
+          pc = ((List<Object>) values[vsp - 1]).size() >= code[pc + 1] ? code[pc + 2] : pc + 3;
+          continue;
+        case TIMES_END:
+          if (((List<Object>) values[vsp - 1]).size() < code[pc + 1]) {
+            break;
+          }
+          context.failureIndex = markIndex;
+          context.failureExpected = markExpected;
+          pc += 2;
+          continue;
+        case MANY_TEST:
+          if (index < input.length()) {
+            pc += 2;
+          } else {
+            context.hitEnd = true;
+            pc = code[pc + 1];
+          }
+          continue;
+        case MANY_APPEND: {
+          if (index == choices[(csp - 1) * CHOICE_SIZE + 1]) {
+            throw new RuntimeException("Infinity loop.");
+          }
+          Object value = values[-- vsp];
+          ((List<Object>) values[vsp - 1]).add(value);
+          pc += 1;
+          continue;
+        }
+        case ROLLBACK:
+          context.failureIndex = markIndex;
+          context.failureExpected = markExpected;
+          pc += 1;
+          continue;
+        case CALL:
+          if (rsp == returns.length) {
+            returns = Arrays.copyOf(returns, rsp << 1);
+          }
+          returns[rsp ++] = pc + 2;
+          pc = code[pc + 1];
+          continue;
+        case RET:
+          pc = returns[-- rsp];
+          continue;
+        case CUT:
+          context.commit(index);
+          pc += 1;
+          continue;
+        case DROP:
+          values[-- vsp] = null;
+          pc += 1;
+          continue;
+        case NIP:
+          values[vsp - 2] = values[vsp - 1];
+          values[-- vsp] = null;
+          pc += 1;
+          continue;
+        case COMBINE: {
+          int count = code[pc + 1];
+          Object value = LLParser.combine(constants[code[pc + 2]], values, vsp - count, count);
+          vsp -= count - 1;
+          values[vsp - 1] = value;
+          pc += 3;
+          continue;
+        }
+        case FOLD: {
+          Object right = values[-- vsp];
+          BiFunction combiner = (BiFunction) values[-- vsp];
+          values[vsp] = null;
+          values[vsp - 1] = combiner.apply(values[vsp - 1], right);
+          pc += 1;
+          continue;
+        }
+        case JUMP:
+          pc = code[pc + 1];
+          continue;
+        case UNARY: {
+          Object operand = values[-- vsp];
+          values[vsp] = null;
+          values[vsp - 1] = ((Function) values[vsp - 1]).apply(operand);
+          pc += 1;
+          continue;
+        }
+        case NODE: {
+          Object right = values[-- vsp];
+          Object operator = values[-- vsp];
+          values[vsp] = null;
+          values[vsp - 1] = ((Arena.Combiner) constants[code[pc + 1]])
+              .combine(context.arena, (Integer) values[vsp - 1], operator, (Integer) right);
+          pc += 2;
+          continue;
+        }
+        case BUILD:
+          values[vsp - 1] = ((Arena.Builder) constants[code[pc + 1]]).build(context.arena(), values[vsp - 1]);
+          pc += 2;
+          continue;
+        default:
+          throw new IllegalStateException("Invalid instruction: " + code[pc]);
+      }
+      // After a cut no choice point of this run may be resumed. The flag stays set for the caller.
+      if (csp == 0 || context.cut) {
+        return failure;
+      }
+      int base = -- csp * CHOICE_SIZE;
+      pc = choices[base];
+      index = choices[base + 1];
+      vsp = choices[base + 2];
+      rsp = choices[base + 3];
+      markIndex = choices[base + 4];
+      context.cut = choices[base + 5] != 0;
+      markExpected = (List<String>) choiceExpectations[csp];
+    }
+  }
+
+  private static final class Compiler {
+
+    private int[] code = new int[64];
+    private int size;
+    private final List<Object> constants = new ArrayList<>();
+    // Keyed by LLParser, whose equality is identity, or by Level.
+    private final Map<Object, List<Integer>> callSites = new HashMap<>();
+    private final List<Object> pending = new ArrayList<>();
+    // How many nodes of the graph use each node, REFERENCE and expression() operators included.
+    private final Map<Parser, Integer> parents = new IdentityHashMap<>();
+
+    Compiler(LLParser root) {
+      List<Parser> stack = new ArrayList<>();
+      stack.add(root);
+      parents.put(root, 0);
+      while (!stack.isEmpty()) {
+        Parser parser = stack.remove(stack.size() - 1);
+        if (!(parser instanceof LLParser)) {
+          continue;
+        }
+        LLParser node = (LLParser) parser;
+        List<Parser> uses = new ArrayList<>(Arrays.asList(node.children()));
+        if (node.kind() == LLParser.Kind.REFERENCE) {
+          uses.add(((LLParser.Reference) node.operand()).get());
+        } else if (node.operand() instanceof OperatorTable) {
+          OperatorTable<?> operators = (OperatorTable<?>) node.operand();
+          for (OperatorTable.Entry entry : operators.infixes) {
+            uses.add(entry.parser);
+          }
+          for (OperatorTable.Entry entry : operators.prefixes) {
+            uses.add(entry.parser);
+          }
+        }
+        for (Parser use : uses) {
+          Integer count = parents.get(use);
+          parents.put(use, count == null ? 1 : count + 1);
+          if (count == null) {
+            stack.add(use);
+          }
+        }
+      }
+    }
+
+    // Emits each referenced parser once, after the main program, and points every CALL at it.
+    void emitSubroutines() {
+      for (int i = 0; i < pending.size(); ++ i) {
+        Object subroutine = pending.get(i);
+        int address = size;
+        if (subroutine instanceof Level) {
+          emitLevel((Level) subroutine);
+        } else {
+          emit((LLParser) subroutine);
+        }
+        emit(RET);
+        for (int callSite : callSites.get(subroutine)) {
+          patch(callSite, address);
+        }
+      }
+    }
+
+    void emit(LLParser parser) {
+      Parser[] children = parser.children();
+      if (parser.isMemoized()) {
+        emit(LEAF, constant(parser));
+        return;
+      }
+      switch (parser.kind()) {
+        case STRING: {
+          String literal = (String) parser.operand();
+          emit(STRING, constant(literal), constant(Expected.of(literal)));
+          break;
+        }
+        case SEQUENCE:
+          for (Parser child : children) {
+            emitChild(child);
+          }
+          emit(LIST, children.length);
+          break;
+        case ALTERNATIVE: {
+          if (children.length == 0) {
+            emit(LEAF, constant(parser));
+            break;
+          }
+          int[] commits = new int[children.length - 1];
+          for (int i = 0; i < children.length - 1; ++ i) {
+            int choice = emit(CHOICE, 0);
+            emitChild(children[i]);
+            commits[i] = emit(COMMIT, 0);
+            patch(choice, size);
+          }
+          emitChild(children[children.length - 1]);
+          for (int commit : commits) {
+            patch(commit, size);
+          }
+          break;
+        }
+        case MAP:
+          emitChild(children[0]);
+          emit(APPLY, constant(parser.operand()));
+          break;
+        case NAMED:
+          emitChild(children[0]);
+          break;
+        case SKIP:
+          emitChild(children[0]);
+          emitChild(children[1]);
+          emit(DROP);
+          break;
+        case THEN:
+          emitChild(children[0]);
+          emitChild(children[1]);
+          emit(NIP);
+          break;
+        case COMBINE:
+          for (Parser child : children) {
+            emitChild(child);
+          }
+          emit(COMBINE, children.length, constant(parser.operand()));
+          break;
+        case TIMES: {
+          int[] bounds = (int[]) parser.operand();
+          emit(NEW_LIST);
+          int loop = size;
+          int test = emit(TIMES_TEST, bounds[1], 0);
+          int choice = emit(CHOICE, 0);
+          emitChild(children[0]);
+          emit(APPEND);
+          emit(COMMIT, loop);
+          patch(choice, size);
+          emit(TIMES_END, bounds[0]);
+          patch(test, size);
+          break;
+        }
+        case COMMIT:
+          emitChild(children[0]);
+          emit(CUT);
+          break;
+        case BUILD:
+          emitChild(children[0]);
+          emit(BUILD, constant(parser.operand()));
+          break;
+        case REFERENCE: {
+          Parser target = ((LLParser.Reference) parser.operand()).get();
+          if (!(target instanceof LLParser)) {
+            emit(LEAF, constant(target));
+            break;
+          }
+          emitCall(target);
+          break;
+        }
+        case CHAIN: {
+          Object shape = parser.operand();
+          if (shape == OperatorTable.Associativity.LEFT || shape instanceof Arena.Combiner) {
+            // operand (operator operand)*: every operator that is followed by an operand is folded in.
+            emitShared(children[0]);
+            int loop = size;
+            int choice = emit(CHOICE, 0);
+            emitChild(children[1]);
+            emitShared(children[0]);
+            if (shape instanceof Arena.Combiner) {
+              emit(NODE, constant(shape));
+            } else {
+              emit(FOLD);
+            }
+            emit(COMMIT, loop);
+            patch(choice, size);
+            emit(ROLLBACK);
+          } else if (shape == OperatorTable.Associativity.RIGHT) {
+            // operand (operator chain)?, with the rest of the chain as a call to this very node.
+            emitShared(children[0]);
+            int choice = emit(CHOICE, 0);
+            emitChild(children[1]);
+            emitCall(parser);
+            emit(FOLD);
+            int commit = emit(COMMIT, 0);
+            patch(choice, size);
+            emit(ROLLBACK);
+            patch(commit, size);
+          } else {
+            emitCall(new Level(parser, Integer.MIN_VALUE));
+          }
+          break;
+        }
+        case MANY: {
+          emit(NEW_LIST);
+          int loop = size;
+          int test = emit(MANY_TEST, 0);
+          int choice = emit(CHOICE, 0);
+          emitChild(children[0]);
+          emit(MANY_APPEND);
+          emit(COMMIT, loop);
+          patch(choice, size);
+          emit(ROLLBACK);
+          patch(test, size);
+          break;
+        }
+        default:
+          emit(LEAF, constant(parser));
+      }
+    }
+
+    // The loop of LLParser.climb() for one minimum precedence, with the right hand sides as calls to
+    // the levels above it. Operators are tried in table order, and once one has matched no other is.
+    private void emitLevel(Level level) {
+      OperatorTable<?> operators = (OperatorTable<?>) level.expression.operand();
+      List<OperatorTable.Entry> infixes = new ArrayList<>();
+      for (OperatorTable.Entry entry : operators.infixes) {
+        if (entry.precedence >= level.minPrecedence) {
+          infixes.add(entry);
+        }
+      }
+      // The first prefix operator that matches applies to the level of its precedence, otherwise
+      // the operand is parsed. Failed prefixes keep their expectations like alternatives do.
+      OperatorTable.Entry[] prefixes = operators.prefixes;
+      int[] operands = new int[prefixes.length];
+      for (int i = 0; i < prefixes.length; ++ i) {
+        int choice = emit(CHOICE, 0);
+        emitShared(prefixes[i].parser);
+        int commit = emit(COMMIT, 0);
+        patch(commit, size);
+        emitCall(new Level(level.expression, prefixes[i].precedence));
+        emit(UNARY);
+        operands[i] = emit(JUMP, 0);
+        patch(choice, size);
+      }
+      emitShared(level.expression.children()[0]);
+      for (int operand : operands) {
+        patch(operand, size);
+      }
+      if (infixes.isEmpty()) {
+        return;
+      }
+      int loop = size;
+      int choice = emit(CHOICE, 0);
+      int[] commits = new int[infixes.size() - 1];
+      int[] joins = new int[infixes.size()];
+      for (int i = 0; i < infixes.size(); ++ i) {
+        int next = i < commits.length ? emit(CHOICE, 0) : -1;
+        emitShared(infixes.get(i).parser);
+        if (next >= 0) {
+          commits[i] = emit(COMMIT, 0);
+          patch(next, size);
+        }
+      }
+      // The last operator falls through to its right hand side, the others commit to theirs.
+      for (int i = infixes.size() - 1; i >= 0; -- i) {
+        if (i < commits.length) {
+          patch(commits[i], size);
+        }
+        OperatorTable.Entry infix = infixes.get(i);
+        int next = infix.associativity == OperatorTable.Associativity.LEFT ? infix.precedence + 1 : infix.precedence;
+        emitCall(new Level(level.expression, next));
+        emit(FOLD);
+        joins[i] = emit(JUMP, 0);
+      }
+      for (int join : joins) {
+        patch(join, size);
+      }
+      emit(COMMIT, loop);
+      patch(choice, size);
+      emit(ROLLBACK);
+    }
+
+    private void emitCall(Object subroutine) {
+      if (!(subroutine instanceof LLParser) && !(subroutine instanceof Level)) {
+        emit(LEAF, constant(subroutine));
+        return;
+      }
+      List<Integer> sites = callSites.get(subroutine);
+      if (sites == null) {
+        sites = new ArrayList<>();
+        callSites.put(subroutine, sites);
+        pending.add(subroutine);
+      }
+      sites.add(emit(CALL, 0));
+    }
+
+    // A node with several parents is emitted once as a subroutine, so that a grammar reusing parts of
+    // itself compiles to code linear in its size.
+    private void emitChild(Parser child) {
+      if (parents.getOrDefault(child, 0) > 1) {
+        emitShared(child);
+      } else if (child instanceof LLParser) {
+        emit((LLParser) child);
+      } else {
+        emit(LEAF, constant(child));
+      }
+    }
+
+    // For a child that is emitted more than once. Nodes that compile to a single LEAF are not worth a call.
+    private void emitShared(Parser child) {
+      if (!(child instanceof LLParser) || isLeaf((LLParser) child)) {
+        emit(LEAF, constant(child));
+      } else if (((LLParser) child).kind() == LLParser.Kind.STRING) {
+        emit((LLParser) child);
+      } else {
+        emitCall(child);
+      }
+    }
+
+    private static boolean isLeaf(LLParser parser) {
+      if (parser.isMemoized()) {
+        return true;
+      }
+      switch (parser.kind()) {
+        case OPAQUE:
+        case TERMINAL:
+        case REGEX:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    // Returns the position of the last operand, so jump targets can be patched once known.
+    private int emit(int... words) {
+      if (size + words.length > code.length) {
+        code = Arrays.copyOf(code, Math.max(code.length << 1, size + words.length));
+      }
+      System.arraycopy(words, 0, code, size, words.length);
+      size += words.length;
+      return size - 1;
+    }
+
+    private void patch(int position, int target) {
+      code[position] = target;
+    }
+
+    private int constant(Object value) {
+      constants.add(value);
+      return constants.size() - 1;
+    }
+  }
+
+  // One minimum precedence of an expression(), compiled once and called from every level below it.
+  private static final class Level {
+    final LLParser expression;
+    final int minPrecedence;
+
+    Level(LLParser expression, int minPrecedence) {
+      this.expression = expression;
+      this.minPrecedence = minPrecedence;
+    }
+
+    @Override
+    public boolean equals(Object other) {
+      return other instanceof Level && ((Level) other).expression == expression
+          && ((Level) other).minPrecedence == minPrecedence;
+    }
+
+    @Override
+    public int hashCode() {
+      return System.identityHashCode(expression) * 31 + minPrecedence;
+    }
+  }
+}
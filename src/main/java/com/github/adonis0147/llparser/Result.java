@@ -1,24 +1,21 @@
 package com.github.adonis0147.llparser;
 
-import java.util.LinkedList;
+import java.util.Collections;
 import java.util.List;
 
 public class Result<T> {
   public Status status;
   public T value;
   public int index;
-  public List<String> expected = new LinkedList<>();
+  // Immutable, and shared with other results and the parsers that produced it.
+  public List<String> expected;
 
   Result(Status status, T value, int index) {
-    this.status = status;
-    this.value = value;
-    this.index = index;
+    this(status, value, index, Collections.emptyList());
   }
 
   Result(Status status, int index, String expected) {
-    this.status = status;
-    this.index = index;
-    this.expected.add(expected);
+    this(status, null, index, Expected.of(expected));
   }
 
   Result(Status status, int index, List<String> expected) {
@@ -29,7 +26,11 @@ public class Result<T> {
     this.status = status;
     this.value = value;
     this.index = index;
-    this.expected.addAll(expected);
+    this.expected = expected;
+  }
+
+  public static <T> Result<T> success(T value, int index) {
+    return new Result<>(Status.SUCCESS, value, index);
   }
 
   @Override
@@ -0,0 +1,130 @@
+package com.github.adonis0147.llparser;
+
+import java.io.IOException;
+import java.io.Reader;
+import java.nio.CharBuffer;
+import java.nio.channels.Channels;
+import java.nio.channels.ReadableByteChannel;
+import java.nio.charset.Charset;
+import java.util.Arrays;
+import java.util.function.Consumer;
+
+// Parses element* over a Reader, handing every element to a consumer as soon as it is complete.
+// Only the element being parsed is buffered: an attempt that looked at the end of the buffered
+// window is retried once more input has been read, and consumed input is discarded.
+public final class StreamParser<T> {
+
+  private static final int CHUNK_SIZE = 1 << 13;
+
+  private final Parser<T> element;
+
+  public StreamParser(Parser<T> element) {
+    if (element == null) {
+      throw new IllegalArgumentException("The element parser is null.");
+    }
+    this.element = element;
+  }
+
+  // Succeeds with the number of elements at the end of the stream. A failure index counts from
+  // the start of the stream. A Result index is an int, so a parse that ends more than
+  // Integer.MAX_VALUE characters into the stream throws IllegalStateException instead of wrapping.
+  public Result<Integer> parse(Reader reader, Consumer<? super T> consumer) throws IOException {
+    Window window = new Window(reader);
+    int count = 0;
+    for (;;) {
+      if (window.isEmpty()) {
+        if (window.exhausted) {
+          return new Result<Integer>(Status.SUCCESS, count, index(window.offset));
+        }
+        window.fill(1);
+        continue;
+      }
+      CharSequence input = window.view();
+      Result<T> result;
+      boolean hitEnd;
+      ParseContext context = ParseContext.open();
+      try {
+        result = context.complete(element.parse(input, 0, context));
+        hitEnd = context.hitEnd;
+      } finally {
+        context.close();
+      }
+      if (hitEnd && !window.exhausted) {
+        // Waiting for as much again as is buffered keeps the retries linear in the element size.
+        window.fill(input.length());
+        continue;
+      }
+      if (result.status == Status.FAILURE) {
+        return new Result<>(Status.FAILURE, index(window.offset + result.index), result.expected);
+      }
+      if (result.index == 0) {
+        throw new RuntimeException("Infinity loop.");
+      }
+      consumer.accept(result.value);
+      window.discard(result.index);
+      ++ count;
+    }
+  }
+
+  public Result<Integer> parse(ReadableByteChannel channel, Charset charset, Consumer<? super T> consumer)
+      throws IOException {
+    return parse(Channels.newReader(channel, charset.newDecoder(), -1), consumer);
+  }
+
+  private static int index(long position) {
+    if (position > Integer.MAX_VALUE) {
+      throw new IllegalStateException("The stream position " + position + " does not fit in a result index.");
+    }
+    return (int) position;
+  }
+
+  private static final class Window {
+
+    private final Reader reader;
+    private char[] buffer = new char[CHUNK_SIZE];
+    private int start;
+    private int end;
+    // How many characters of the stream were discarded before start.
+    long offset;
+    boolean exhausted;
+
+    Window(Reader reader) {
+      this.reader = reader;
+    }
+
+    boolean isEmpty() {
+      return start == end;
+    }
+
+    CharSequence view() {
+      return CharBuffer.wrap(buffer, start, end - start);
+    }
+
+    void discard(int count) {
+      start += count;
+      offset += count;
+    }
+
+    // Reads until at least count more characters are buffered or the reader is exhausted. Every read
+    // takes as much as fits, so the buffer is at least CHUNK_SIZE.
+    void fill(int count) throws IOException {
+      if (start > 0) {
+        System.arraycopy(buffer, start, buffer, 0, end - start);
+        end -= start;
+        start = 0;
+      }
+      if (end + count > buffer.length) {
+        buffer = Arrays.copyOf(buffer, Math.max(buffer.length << 1, end + count));
+      }
+      int target = end + count;
+      while (end < target) {
+        int read = reader.read(buffer, end, buffer.length - end);
+        if (read < 0) {
+          exhausted = true;
+          return;
+        }
+        end += read;
+      }
+    }
+  }
+}
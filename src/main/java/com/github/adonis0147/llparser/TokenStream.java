@@ -0,0 +1,78 @@
+package com.github.adonis0147.llparser;
+
+// The tokens of a Lexer as parallel arrays of types and bounds. As a CharSequence it reads as one
+// char per token, its type, so any parser runs over it unchanged with token indexes for char indexes.
+public final class TokenStream implements CharSequence {
+
+  private final CharSequence text;
+  private final char[] types;
+  private final int[] starts;
+  private final int[] ends;
+  private final int count;
+
+  TokenStream(CharSequence text, char[] types, int[] starts, int[] ends, int count) {
+    this.text = text;
+    this.types = types;
+    this.starts = starts;
+    this.ends = ends;
+    this.count = count;
+  }
+
+  public CharSequence text() {
+    return text;
+  }
+
+  public int type(int token) {
+    return charAt(token);
+  }
+
+  public int start(int token) {
+    checkIndex(token);
+    return starts[token];
+  }
+
+  public int end(int token) {
+    checkIndex(token);
+    return ends[token];
+  }
+
+  public String text(int token) {
+    checkIndex(token);
+    return text.subSequence(starts[token], ends[token]).toString();
+  }
+
+  // The offset in the text of a token index, the end of the text for the index past the last token.
+  public int offset(int token) {
+    return token < count ? start(token) : text.length();
+  }
+
+  @Override
+  public int length() {
+    return count;
+  }
+
+  @Override
+  public char charAt(int index) {
+    checkIndex(index);
+    return types[index];
+  }
+
+  @Override
+  public CharSequence subSequence(int start, int end) {
+    if (start < 0 || end > count || start > end) {
+      throw new IndexOutOfBoundsException("start " + start + ", end " + end + ", length " + count);
+    }
+    return new String(types, start, end - start);
+  }
+
+  @Override
+  public String toString() {
+    return new String(types, 0, count);
+  }
+
+  private void checkIndex(int index) {
+    if (index < 0 || index >= count) {
+      throw new IndexOutOfBoundsException("index " + index + ", length " + count);
+    }
+  }
+}
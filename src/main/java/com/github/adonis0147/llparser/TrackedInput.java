@@ -0,0 +1,41 @@
+package com.github.adonis0147.llparser;
+
+// Records in the context how far the parse has read, so memo entries know which part of the input
+// they depend on. The String copy from toString() is read untracked, so it counts as reading it all.
+final class TrackedInput implements CharSequence {
+
+  private final GapBuffer text;
+  private final ParseContext context;
+
+  TrackedInput(GapBuffer text, ParseContext context) {
+    this.text = text;
+    this.context = context;
+  }
+
+  @Override
+  public int length() {
+    return text.length();
+  }
+
+  @Override
+  public char charAt(int index) {
+    if (index >= context.examined) {
+      context.examined = index + 1;
+    }
+    return text.charAt(index);
+  }
+
+  @Override
+  public CharSequence subSequence(int start, int end) {
+    if (end > context.examined) {
+      context.examined = end;
+    }
+    return text.subSequence(start, end);
+  }
+
+  @Override
+  public String toString() {
+    context.examined = MemoTable.UNBOUNDED;
+    return text.toString();
+  }
+}
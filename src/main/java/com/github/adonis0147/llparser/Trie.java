@@ -0,0 +1,93 @@
+package com.github.adonis0147.llparser;
+
+import java.util.Arrays;
+import java.util.Map;
+
+// A set of literals keyed by their characters. Children are kept sorted so a step is one binary
+// search, and matching walks the input once no matter how many literals there are.
+final class Trie {
+
+  private static final char[] NO_LABELS = new char[0];
+  private static final Node[] NO_NODES = new Node[0];
+
+  static final class Node {
+    private char[] labels = NO_LABELS;
+    private Node[] children = NO_NODES;
+    final int depth;
+    boolean terminal;
+    Object value;
+
+    private Node(int depth) {
+      this.depth = depth;
+    }
+
+    private Node child(char c) {
+      int position = Arrays.binarySearch(labels, c);
+      return position < 0 ? null : children[position];
+    }
+
+    private Node add(char c) {
+      int position = Arrays.binarySearch(labels, c);
+      if (position >= 0) {
+        return children[position];
+      }
+      position = -position - 1;
+      Node node = new Node(depth + 1);
+      char[] labels = new char[this.labels.length + 1];
+      Node[] children = new Node[labels.length];
+      System.arraycopy(this.labels, 0, labels, 0, position);
+      System.arraycopy(this.children, 0, children, 0, position);
+      labels[position] = c;
+      children[position] = node;
+      System.arraycopy(this.labels, position, labels, position + 1, this.labels.length - position);
+      System.arraycopy(this.children, position, children, position + 1, this.children.length - position);
+      this.labels = labels;
+      this.children = children;
+      return node;
+    }
+  }
+
+  private final Node root = new Node(0);
+
+  // The first value given for a literal wins.
+  Trie(Map<String, ?> literals) {
+    for (Map.Entry<String, ?> entry : literals.entrySet()) {
+      String literal = entry.getKey();
+      Node node = root;
+      for (int i = 0; i < literal.length(); ++ i) {
+        node = node.add(literal.charAt(i));
+      }
+      if (!node.terminal) {
+        node.terminal = true;
+        node.value = entry.getValue();
+      }
+    }
+  }
+
+  String firstChars() {
+    return new String(root.labels);
+  }
+
+  // The node of the longest literal at index, or null. Sets the context's hitEnd flag when the
+  // input ran out while a longer literal was still possible.
+  Node match(CharSequence input, int index, ParseContext context) {
+    int length = input.length();
+    Node node = root;
+    Node longest = null;
+    for (int i = index; ; ++ i) {
+      if (i >= length) {
+        if (node.labels.length > 0) {
+          context.hitEnd = true;
+        }
+        return longest;
+      }
+      node = node.child(input.charAt(i));
+      if (node == null) {
+        return longest;
+      }
+      if (node.terminal) {
+        longest = node;
+      }
+    }
+  }
+}
@@ -4,4 +4,20 @@ public class Utils {
   public static boolean isStringNullOrEmpty(String s) {
     return s == null || s.isEmpty();
   }
+
+  public static boolean regionMatches(CharSequence input, int index, String literal) {
+    if (input instanceof String) {
+      return ((String) input).regionMatches(index, literal, 0, literal.length());
+    }
+    int length = literal.length();
+    if (index < 0 || index > input.length() - length) {
+      return false;
+    }
+    for (int i = 0; i < length; ++ i) {
+      if (input.charAt(index + i) != literal.charAt(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
 }
@@ -1,118 +1,234 @@
 package com.github.adonis0147.llparser.examples.arithmetic;
 
+import com.github.adonis0147.llparser.Arena;
+import com.github.adonis0147.llparser.IntParser;
 import com.github.adonis0147.llparser.LLParser;
+import com.github.adonis0147.llparser.OperatorTable;
 import com.github.adonis0147.llparser.Parser;
 import com.github.adonis0147.llparser.Result;
 import com.github.adonis0147.llparser.Status;
 
 import java.util.ArrayList;
-import java.util.LinkedList;
+import java.util.LinkedHashMap;
 import java.util.List;
+import java.util.Map;
+import java.util.TreeMap;
+import java.util.concurrent.atomic.AtomicReference;
 import java.util.function.BiFunction;
 import java.util.function.Function;
 
 public class ArithmeticParser {
 
-  private static final Parser NUMBER_LITERAL = LLParser.regex("\\d+")
-      .map(new Function<String, Number>() {
+  private static final Parser<Token> NUMBER_LITERAL = LLParser.INTEGER
+      .map(new Function<Integer, Number>() {
         @Override
-        public Number apply(String value) {
-          return new Number(Integer.parseInt(value));
+        public Number apply(Integer value) {
+          return new Number(value);
         }
       });
-  private static final Parser OPERATOR_LITERAL = LLParser.regex("\\+|-|\\*|/")
-      .map(new Function<String, Operator>() {
-        @Override
-        public Operator apply(String value) {
-          return Operator.getOperator(value);
-        }
-      });
-  public static final Parser LEFT_BRACE_LITERAL = LLParser.string("(");
-  public static final Parser RIGHT_BRACE_LITERAL = LLParser.string(")");
+  public static final Parser<String> LEFT_BRACE_LITERAL = LLParser.string("(");
+  public static final Parser<String> RIGHT_BRACE_LITERAL = LLParser.string(")");
+  private static final Parser<Token> BASIC_EXPRESSION_REFERENCE = LLParser.lazy(() -> ArithmeticParser.BASIC_EXPRESSION);
+  // The precedences of Operator, where '*' and '/' bind tighter than '+' and '-'.
+  private static final OperatorTable<Token> OPERATORS = tokenOperators();
   // S -> E (op E)*
-  public static final Parser GENERAL_EXPRESSION = new LLParser(new BiFunction<String, Integer, Result>() {
-    @Override
-    public Result apply(String input, Integer index) {
-      return LLParser.sequence(
-          BASIC_EXPRESSION,
-          LLParser.sequence(
-              tokenize(OPERATOR_LITERAL),
-              BASIC_EXPRESSION
-          ).atLeast(0)
-      ).map(new Function<Object, List<Object>>() {
-        @Override
-        public List<Object> apply(Object values) {
-          return collect(values);
-        }
-      }).parse(input, index);
-    }
-  }).map(new Function<List<Object>, Token>() {
-    @Override
-    public Token apply(List<Object> values) {
-      return evaluate(values);
-    }
-  });
-  // E -> T | (S)
-  public static final Parser BASIC_EXPRESSION = tokenize(NUMBER_LITERAL).or(
-      tokenize(LEFT_BRACE_LITERAL)
+  public static final Parser<Token> GENERAL_EXPRESSION = LLParser.expression(BASIC_EXPRESSION_REFERENCE, OPERATORS);
+  // E -> T | (S), where nothing but S) can follow a (
+  public static final Parser<Token> BASIC_EXPRESSION = tokenize(NUMBER_LITERAL).or(
+      tokenize(LEFT_BRACE_LITERAL).commit()
           .then(GENERAL_EXPRESSION)
           .skip(tokenize(RIGHT_BRACE_LITERAL))
   );
 
-  private static List<Object> collect(Object values) {
-    List<Object> tokens = new ArrayList<>();
-    tokens.add(((List<Object>)values).get(0));
-    List<List<Object>> second = (List<List<Object>>)((List<Object>)values).get(1);
-    for (List<Object> item : second) {
-      tokens.addAll(item);
+  private static OperatorTable<Token> tokenOperators() {
+    OperatorTable<Token> operators = new OperatorTable<>();
+    for (Operator operator : Operator.values()) {
+      operators = operators.infix(operator(operator), operator.precedence(), OperatorTable.Associativity.LEFT);
     }
-    return tokens;
+    return operators;
+  }
+
+  private static Parser<BiFunction<Token, Token, Token>> operator(Operator operator) {
+    BiFunction<Token, Token, Token> combiner = (lhs, rhs) -> new Expression(lhs, operator, rhs);
+    return tokenize(LLParser.string(operator.toString())).map(new Function<String, BiFunction<Token, Token, Token>>() {
+      @Override
+      public BiFunction<Token, Token, Token> apply(String value) {
+        return combiner;
+      }
+    });
+  }
+
+  private static <T> Parser<T> tokenize(Parser<T> parser) {
+    return parser.skip(LLParser.OPTIONAL_WHITESPACES);
   }
 
-  private static Token evaluate(List<Object> values) {
-    LinkedList<Token> tokenStack = new LinkedList<>();
-    LinkedList<Operator> operatorStack = new LinkedList<>();
-    tokenStack.push((Token)values.get(0));
-    for (int i = 1; i < values.size(); i += 2) {
-      Operator operator = (Operator)values.get(i);
-      Token number = (Token)values.get(i + 1);
-      if (operatorStack.isEmpty() || !Operator.doesPrecede(operator, operatorStack.peek())) {
-        operatorStack.push(operator);
-        tokenStack.push(number);
-      } else {
-        Expression expression = new Expression(tokenStack.pop(), operator, number);
-        tokenStack.push(expression);
+  // Compiled, so that nesting only grows the program's heap allocated stacks, not the Java stack.
+  private static final Parser<Token> PARSER = LLParser.OPTIONAL_WHITESPACES
+      .then(GENERAL_EXPRESSION)
+      .skip(LLParser.OPTIONAL_WHITESPACES)
+      .compile();
+
+  // The same grammar building a flat tree in an Arena instead of Tokens: a number is a leaf of kind
+  // NUMBER holding its value, an operation a node of its operator's ordinal with the operands as children.
+  public static final int NUMBER = -1;
+  // A leaf holding the position of a variable's name in the text, start << 32 | length.
+  public static final int VARIABLE = -2;
+
+  // An unsigned decimal long, accumulated while scanning. Values that overflow a long do not match.
+  private static final Parser<Long> LONG = new LLParser<Long>((input, index, context) -> {
+    int length = input.length();
+    int end = index;
+    long value = 0;
+    while (end < length && input.charAt(end) >= '0' && input.charAt(end) <= '9') {
+      int digit = input.charAt(end) - '0';
+      if (value > (Long.MAX_VALUE - digit) / 10) {
+        return context.failure(index, "integer");
       }
+      value = value * 10 + digit;
+      ++ end;
+    }
+    if (end == length) {
+      context.hitEnd();
     }
-    Token result = tokenStack.pollLast();
-    while (!operatorStack.isEmpty()) {
-      result = new Expression(result, operatorStack.pollLast(), tokenStack.pollLast());
+    if (end == index) {
+      return context.failure(index, "integer");
     }
-    return result;
+    return Result.success(value, end);
+  });
+  // An identifier as its position in the text, so that one grammar serves every compile() call.
+  private static final Parser<Long> NAME = new LLParser<Long>((input, index, context) -> {
+    Result<String> result = LLParser.IDENTIFIER.parse(input, index, context);
+    if (result.status == Status.FAILURE) {
+      // A failure carries no value, so it serves as a Result<Long> as well.
+      @SuppressWarnings("unchecked")
+      Result<Long> failure = (Result<Long>) (Result<?>) result;
+      return failure;
+    }
+    return Result.success((long) index << 32 | (result.index - index), result.index);
+  });
+  private static final Parser<Integer> NODE_PARSER = grammar(false, ArithmeticParser::node);
+  private static final Parser<Integer> VARIABLE_PARSER = grammar(true, ArithmeticParser::node);
+  // Folds every operation into a leaf of its value as soon as both operands are parsed.
+  private static final Parser<Integer> VALUE_PARSER = grammar(false, ArithmeticParser::fold);
+  private static final ThreadLocal<Arena> VALUES = ThreadLocal.withInitial(Arena::new);
+
+  // S -> T (('+' | '-') T)*, T -> E (('*' | '/') E)*, E -> number | variable | (S), one chainl() per
+  // precedence level of Operator. Compiled like PARSER, so any nesting depth parses. Variables are
+  // only part of the syntax if asked for. combiner builds the node of each operation.
+  private static Parser<Integer> grammar(boolean variables, Arena.Combiner<Operator> combiner) {
+    TreeMap<Integer, List<Operator>> levels = new TreeMap<>();
+    for (Operator operator : Operator.values()) {
+      levels.computeIfAbsent(operator.precedence(), key -> new ArrayList<>()).add(operator);
+    }
+    AtomicReference<Parser<Integer>> basic = new AtomicReference<>();
+    IntParser general = IntParser.unboxed(LLParser.lazy(basic::get));
+    for (List<Operator> level : levels.descendingMap().values()) {
+      general = general.chainl(operators(level), combiner);
+    }
+    Parser<Integer> leaf = tokenize(LONG).build((arena, value) -> arena.leaf(NUMBER, value));
+    if (variables) {
+      leaf = leaf.or(tokenize(NAME).build((arena, name) -> arena.leaf(VARIABLE, name)));
+    }
+    basic.set(leaf.or(
+        tokenize(LEFT_BRACE_LITERAL).commit()
+            .then(general)
+            .skip(tokenize(RIGHT_BRACE_LITERAL))
+    ));
+    return LLParser.OPTIONAL_WHITESPACES
+        .then(general)
+        .skip(LLParser.OPTIONAL_WHITESPACES)
+        .compile();
   }
 
-  private static Parser tokenize(Parser parser) {
-    return parser.skip(LLParser.OPTIONAL_WHITESPACES);
+  private static Parser<Operator> operators(List<Operator> operators) {
+    Map<String, Operator> literals = new LinkedHashMap<>();
+    for (Operator operator : operators) {
+      literals.put(operator.toString(), operator);
+    }
+    return tokenize(LLParser.oneOf(literals));
   }
 
-  private static final Parser PARSER = LLParser.lazy(
-      LLParser.OPTIONAL_WHITESPACES
-          .then(GENERAL_EXPRESSION)
-          .skip(LLParser.OPTIONAL_WHITESPACES)
-  );
+  private static int node(Arena arena, int left, Operator operator, int right) {
+    return arena.node(operator.ordinal(), left, right);
+  }
+
+  // An operation that overflows or divides by zero stays a node over the leaves of its operands, and
+  // every operation it is part of folds into it, so that evaluate() throws only once the text parsed.
+  private static int fold(Arena arena, int left, Operator operator, int right) {
+    if (arena.kind(left) != NUMBER) {
+      return left;
+    } else if (arena.kind(right) != NUMBER) {
+      return right;
+    }
+    try {
+      return arena.leaf(NUMBER, operator.apply(arena.value(left), arena.value(right)));
+    } catch (ArithmeticException e) {
+      return node(arena, left, operator, right);
+    }
+  }
 
   public Token parse(String text) {
     Result<Token> result = PARSER.parse(text);
     if (result.status == Status.SUCCESS) {
       return result.value;
-    } else {
-      int index = result.index;
-      int left = index - 3, right = index + 6;
-      String content = (left > 0 ? "(..." : "(") +
-          text.substring(Math.max(0, left), Math.min(right, text.length())) +
-          (right < text.length() - 1 ? "..." : ")");
-      throw new IllegalArgumentException("Failed to parse the arithmetic expression. columns: " +
-          result.index + ", expected: " + result.expected + ", content: " + content);
     }
+    throw error(text, result);
+  }
+
+  // Parses into the arena and returns the root node, without allocating a Token per node.
+  public int parse(String text, Arena arena) {
+    Result<Integer> result = arena.parse(NODE_PARSER, text);
+    if (result.status == Status.SUCCESS) {
+      return result.value;
+    }
+    throw error(text, result);
+  }
+
+  // The value of the expression, folded while parsing into a reused Arena. A syntax error is
+  // reported before any overflow or division by zero, which throw ArithmeticException.
+  public long evaluate(String text) {
+    Arena values = VALUES.get();
+    values.reset();
+    Result<Integer> result = values.parse(VALUE_PARSER, text);
+    if (result.status == Status.FAILURE) {
+      throw error(text, result);
+    }
+    int root = result.value;
+    int kind = values.kind(root);
+    if (kind == NUMBER) {
+      return values.value(root);
+    }
+    // The first operation that failed to fold, applied again to throw its exception.
+    return Operator.values()[kind].apply(values.value(values.left(root)), values.value(values.right(root)));
+  }
+
+  // Parses an expression over variables once, to be evaluated for many of their values.
+  public Evaluator compile(String text) {
+    Arena arena = new Arena();
+    Result<Integer> result = arena.parse(VARIABLE_PARSER, text);
+    if (result.status == Status.SUCCESS) {
+      return new Evaluator(arena, result.value, text);
+    }
+    throw error(text, result);
+  }
+
+  // Renders a node built by parse(text, arena) the way Token.toString() renders the tree.
+  public static String toString(Arena arena, int node) {
+    int kind = arena.kind(node);
+    if (kind == NUMBER) {
+      return String.valueOf(arena.value(node));
+    }
+    return "(" + toString(arena, arena.left(node)) + " " + Operator.values()[kind] + " " +
+        toString(arena, arena.right(node)) + ")";
+  }
+
+  private static IllegalArgumentException error(String text, Result<?> result) {
+    int index = result.index;
+    int left = index - 3, right = index + 6;
+    String content = (left > 0 ? "(..." : "(") +
+        text.substring(Math.max(0, left), Math.min(right, text.length())) +
+        (right < text.length() - 1 ? "..." : ")");
+    return new IllegalArgumentException("Failed to parse the arithmetic expression. columns: " +
+        result.index + ", expected: " + result.expected + ", content: " + content);
   }
 }
\ No newline at end of file
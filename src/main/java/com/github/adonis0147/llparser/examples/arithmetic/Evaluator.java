@@ -0,0 +1,88 @@
+package com.github.adonis0147.llparser.examples.arithmetic;
+
+import com.github.adonis0147.llparser.Arena;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+// An expression compiled by ArithmeticParser.compile() into postfix code over a stack of longs, to
+// be evaluated any number of times without parsing it again. Variables are numbered in the order of
+// their first occurrence. Evaluators are immutable.
+public final class Evaluator {
+
+  private static final Operator[] OPERATORS = Operator.values();
+
+  // Per instruction: NUMBER with its value, VARIABLE with its position, or an operator's ordinal.
+  private final int[] kinds;
+  private final long[] operands;
+  private final List<String> variables;
+  private final int depth;
+
+  // text is what the arena was parsed from, for the names of the variables.
+  Evaluator(Arena arena, int root, CharSequence text) {
+    Map<String, Integer> variables = new LinkedHashMap<>();
+    int count = 0;
+    int[] pending = new int[arena.size()];
+    boolean[] expanded = new boolean[arena.size()];
+    int[] kinds = new int[arena.size()];
+    long[] operands = new long[arena.size()];
+    int top = 0, height = 0, depth = 0;
+    // Post order with an explicit stack, so that deeply nested expressions compile too.
+    pending[top ++] = root;
+    while (top > 0) {
+      int node = pending[-- top];
+      int kind = arena.kind(node);
+      if (kind < 0 || expanded[node]) {
+        kinds[count] = kind;
+        operands[count] = arena.value(node);
+        if (kind == ArithmeticParser.VARIABLE) {
+          int start = (int) (operands[count] >>> 32);
+          String name = text.subSequence(start, start + (int) operands[count]).toString();
+          operands[count] = variables.computeIfAbsent(name, key -> variables.size());
+        }
+        ++ count;
+        height += kind < 0 ? 1 : -1;
+        depth = Math.max(depth, height);
+      } else {
+        expanded[node] = true;
+        pending[top ++] = node;
+        pending[top ++] = arena.right(node);
+        pending[top ++] = arena.left(node);
+      }
+    }
+    this.kinds = Arrays.copyOf(kinds, count);
+    this.operands = Arrays.copyOf(operands, count);
+    this.variables = Collections.unmodifiableList(new ArrayList<>(variables.keySet()));
+    this.depth = depth;
+  }
+
+  // The variables of the expression in the order of their first occurrence.
+  public List<String> variables() {
+    return variables;
+  }
+
+  // Evaluates the expression with the values of variables() in the same order.
+  public long evaluate(long ...values) {
+    if (values.length != variables.size()) {
+      throw new IllegalArgumentException("Expected " + variables.size() + " values, got " + values.length + ".");
+    }
+    long[] stack = new long[depth];
+    int top = 0;
+    for (int i = 0; i < kinds.length; ++ i) {
+      int kind = kinds[i];
+      if (kind == ArithmeticParser.NUMBER) {
+        stack[top ++] = operands[i];
+      } else if (kind == ArithmeticParser.VARIABLE) {
+        stack[top ++] = values[(int) operands[i]];
+      } else {
+        -- top;
+        stack[top - 1] = OPERATORS[kind].apply(stack[top - 1], stack[top]);
+      }
+    }
+    return stack[0];
+  }
+}
@@ -1,29 +1,43 @@
 package com.github.adonis0147.llparser.examples.arithmetic;
 
+// The one precedence table of ArithmeticParser's grammars: a higher precedence binds tighter, and
+// every operator is left associative.
 public enum Operator {
-  ADDITION("+"),
-  SUBTRACTION("-"),
-  MULTIPLICATION("*"),
-  DIVISION("/");
+  ADDITION("+", 1),
+  SUBTRACTION("-", 1),
+  MULTIPLICATION("*", 2),
+  DIVISION("/", 2);
 
   private final String operator;
+  private final int precedence;
 
-  private Operator(String operator) {
+  private Operator(String operator, int precedence) {
     this.operator = operator;
+    this.precedence = precedence;
   }
 
-  static Operator getOperator(String op) {
-    for (Operator value : values()) {
-      if (value.operator.equals(op)) {
-        return value;
-      }
-    }
-    throw new IllegalArgumentException("Invalid operator: " + op);
+  int precedence() {
+    return precedence;
   }
 
-  static boolean doesPrecede(Operator operator, Operator otherOperator) {
-    return (operator == MULTIPLICATION || operator == DIVISION) &&
-        (otherOperator == ADDITION || otherOperator == SUBTRACTION);
+  // Exact long arithmetic: overflows and divisions by zero throw instead of wrapping around.
+  long apply(long lhs, long rhs) {
+    switch (this) {
+      case ADDITION:
+        return Math.addExact(lhs, rhs);
+      case SUBTRACTION:
+        return Math.subtractExact(lhs, rhs);
+      case MULTIPLICATION:
+        return Math.multiplyExact(lhs, rhs);
+      default:
+        if (rhs == 0) {
+          throw new ArithmeticException("Division by zero.");
+        }
+        if (lhs == Long.MIN_VALUE && rhs == -1) {
+          throw new ArithmeticException("long overflow");
+        }
+        return lhs / rhs;
+    }
   }
 
   @Override
@@ -2,12 +2,27 @@ package com.github.adonis0147.llparser;
 
 import org.junit.Test;
 
+import java.io.ByteArrayInputStream;
+import java.io.IOException;
+import java.io.Reader;
+import java.io.StringReader;
+import java.nio.CharBuffer;
+import java.nio.channels.Channels;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Collections;
+import java.util.HashMap;
 import java.util.List;
+import java.util.Map;
+import java.util.function.BiFunction;
 import java.util.function.Function;
+import java.util.function.IntBinaryOperator;
 
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertThrows;
+import static org.junit.Assert.assertTrue;
 
 public class TestLLParser {
 
@@ -29,6 +44,10 @@ public class TestLLParser {
     text = "aa";
     result = parser.parse(text);
     assertEquivalentResults(new Result<String>(Status.FAILURE, 1, "EOF"), result);
+
+    parser = LLParser.string(new String("key"));
+    result = parser.parse(new StringBuilder("key").toString());
+    assertSame("key", result.value);
   }
 
   private void assertEquivalentResults(Result expect, Result actual) {
@@ -122,6 +141,26 @@ public class TestLLParser {
     assertEquivalentResults(new Result<String>(Status.SUCCESS, text, text.length()), result);
   }
 
+  @Test
+  public void testFarthestFailure() {
+    Parser parser = LLParser.alternative(
+        LLParser.sequence(LLParser.string("a"), LLParser.string("b")),
+        LLParser.string("a"),
+        LLParser.string("c")
+    );
+    String text = "ad";
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(
+        Status.FAILURE, 1, Arrays.asList("b", "EOF")
+    ), result);
+
+    text = "d";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(
+        Status.FAILURE, 0, Arrays.asList("a", "c")
+    ), result);
+  }
+
   @Test
   public void testMap() {
     String pattern = "\\w+";
@@ -411,4 +450,811 @@ public class TestLLParser {
         Status.SUCCESS, "test", text.length()
     ), result);
   }
+
+  @Test
+  public void testCharClass() {
+    Parser parser = LLParser.character(CharClass.of("+-"));
+    String text = "-";
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "-", text.length()), result);
+
+    text = "*";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, "one of \"+-\""), result);
+
+    parser = LLParser.span(CharClass.range('a', 'f').or(CharClass.DIGIT), 2);
+    text = "3fa9";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, text, text.length()), result);
+
+    text = "3g";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, "'a'-'f' or digit"), result);
+
+    text = "\t \u000B\f\r\n";
+    result = LLParser.WHITESPACES.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, text, text.length()), result);
+  }
+
+  @Test
+  public void testNumbers() {
+    String text = "2147483647";
+    Result result = LLParser.INTEGER.parse(text);
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, Integer.MAX_VALUE, text.length()), result);
+
+    text = "2147483648";
+    result = LLParser.INTEGER.parse(text);
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 0, "integer"), result);
+
+    text = "x";
+    result = LLParser.INTEGER.parse(text);
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 0, "integer"), result);
+
+    text = "3.25";
+    result = LLParser.DECIMAL.parse(text);
+    assertEquivalentResults(new Result<Double>(Status.SUCCESS, 3.25, text.length()), result);
+
+    text = "0.1";
+    result = LLParser.DECIMAL.parse(text);
+    assertEquivalentResults(new Result<Double>(Status.SUCCESS, 0.1, text.length()), result);
+
+    text = "12345678901234567.5";
+    result = LLParser.DECIMAL.parse(text);
+    assertEquivalentResults(new Result<Double>(Status.SUCCESS, 12345678901234567.5, text.length()), result);
+
+    text = "42.";
+    result = LLParser.DECIMAL.parse(text);
+    assertEquivalentResults(new Result<Double>(Status.FAILURE, 2, "EOF"), result);
+
+    text = "_key1 ";
+    result = LLParser.IDENTIFIER.skip(LLParser.WHITESPACES).parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "_key1", text.length()), result);
+
+    text = "1key";
+    result = LLParser.IDENTIFIER.parse(text);
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, "identifier"), result);
+  }
+
+  @Test
+  public void testParseFunction() {
+    Parser parser = new LLParser((input, index, context) -> {
+      int end = index;
+      while (end < input.length() && input.charAt(end) == 'x') {
+        ++ end;
+      }
+      return end > index ? Result.success(end - index, end) : context.failure(index, "x");
+    });
+    String text = "xxx";
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 3, text.length()), result);
+
+    text = "y";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 0, "x"), result);
+  }
+
+  @Test
+  public void testCompile() {
+    Function<List<String>, String> concat = new Function<List<String>, String>() {
+      @Override
+      public String apply(List<String> values) {
+        StringBuilder builder = new StringBuilder();
+        values.forEach(builder::append);
+        return builder.toString();
+      }
+    };
+    Parser parser = LLParser.alternative(
+        LLParser.string("'").then(LLParser.regex("\\w+")).skip(LLParser.string("'")),
+        LLParser.regex("\\d").times(2, 3).map(concat),
+        LLParser.string("a").many().map(concat).skip(LLParser.string(";")),
+        LLParser.string("b").atLeast(1).map(concat)
+    );
+    Parser compiled = parser.compile();
+    for (String text : Arrays.asList("'key'", "'key", "12", "123", "1234", "1", "aaa;", ";", "aa", "bbb", "", "c")) {
+      assertEquivalentResults(parser.parse(text), compiled.parse(text));
+    }
+
+    Result result = compiled.parse("aa");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 2, ";"), result);
+  }
+
+  @Test
+  public void testLazy() {
+    int[] calls = new int[1];
+    Parser[] grammar = new Parser[1];
+    Parser reference = LLParser.lazy(() -> {
+      ++ calls[0];
+      return grammar[0];
+    });
+    grammar[0] = LLParser.string("(").then(reference.many()).skip(LLParser.string(")"));
+    String text = "(()())";
+    Result result = grammar[0].parse(text);
+    assertEquivalentResults(new Result<List<Object>>(
+        Status.SUCCESS, Arrays.<Object>asList(Collections.emptyList(), Collections.emptyList()), text.length()
+    ), result);
+
+    text = "(()";
+    result = grammar[0].parse(text);
+    assertEquivalentResults(new Result<List<Object>>(Status.FAILURE, 3, ")"), result);
+
+    Parser compiled = grammar[0].compile();
+    StringBuilder builder = new StringBuilder();
+    for (int i = 0; i < 100000; ++ i) {
+      builder.append('(');
+    }
+    for (int i = 0; i < 100000; ++ i) {
+      builder.append(')');
+    }
+    text = builder.toString();
+    result = compiled.parse(text);
+    assertEquals(Status.SUCCESS, result.status);
+    assertEquals(text.length(), result.index);
+    assertEquals(1, calls[0]);
+  }
+
+  @Test
+  public void testMemoize() {
+    int[] calls = new int[1];
+    Parser key = LLParser.regex("\\w+").map(new Function<String, String>() {
+      @Override
+      public String apply(String value) {
+        ++ calls[0];
+        return value;
+      }
+    });
+    Parser parser = LLParser.alternative(
+        key.skip(LLParser.string("=")),
+        key.skip(LLParser.string(":"))
+    );
+    String text = "key:";
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "key", text.length()), result);
+    assertEquals(2, calls[0]);
+
+    calls[0] = 0;
+    key = key.memoize();
+    parser = LLParser.alternative(
+        key.skip(LLParser.string("=")),
+        key.skip(LLParser.string(":"))
+    );
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "key", text.length()), result);
+    assertEquals(1, calls[0]);
+
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "key", text.length()), result);
+    assertEquals(2, calls[0]);
+
+    // A map over a memoized parser reads the memo table as well.
+    calls[0] = 0;
+    Parser counted = new LLParser<String>((input, index, context) -> {
+      ++ calls[0];
+      return LLParser.IDENTIFIER.parse(input, index, context);
+    }).memoize().map(String::toUpperCase);
+    parser = LLParser.alternative(
+        counted.skip(LLParser.string("=")),
+        counted.skip(LLParser.string(":"))
+    );
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "KEY", text.length()), result);
+    assertEquals(1, calls[0]);
+  }
+
+  @Test
+  public void testPackrat() {
+    int[] calls = new int[1];
+    Parser key = LLParser.regex("\\w+").map(new Function<String, String>() {
+      @Override
+      public String apply(String value) {
+        ++ calls[0];
+        return value;
+      }
+    });
+    Parser parser = LLParser.alternative(
+        key.skip(LLParser.string("=")),
+        key.skip(LLParser.string(":"))
+    ).packrat();
+    String text = "key:";
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "key", text.length()), result);
+    assertEquals(1, calls[0]);
+
+    text = "key;";
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(
+        Status.FAILURE, 3, Arrays.asList("=", ":")
+    ), result);
+    assertEquals(2, calls[0]);
+  }
+
+  @Test
+  public void testCharSequence() {
+    Parser parser = LLParser.sequence(
+        LLParser.OPTIONAL_WHITESPACES,
+        LLParser.string("key"),
+        LLParser.regex("\\s*=\\s*"),
+        LLParser.INTEGER,
+        LLParser.of((input, index) -> new Result<String>(Status.SUCCESS, input.substring(index), input.length()))
+    );
+    char[] chars = " key = 42;".toCharArray();
+    for (CharSequence text : Arrays.<CharSequence>asList(
+        CharBuffer.wrap(chars), new StringBuilder().append(chars), CharBuffer.wrap(chars, 0, chars.length))) {
+      Result result = parser.parse(text);
+      assertEquivalentResults(new Result<List<Object>>(
+          Status.SUCCESS, Arrays.<Object>asList(" ", "key", " = ", 42, ";"), chars.length
+      ), result);
+    }
+
+    Result result = LLParser.string("key").parse(CharBuffer.wrap("key;"));
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 3, "EOF"), result);
+  }
+
+  @Test
+  public void testStreamParser() throws IOException {
+    StreamParser parser = new StreamParser(LLParser.INTEGER.skip(LLParser.OPTIONAL_WHITESPACES));
+    String text = "12 345  6 7890";
+    List<Object> values = new ArrayList<>();
+    // Hands out one character per read, so every element straddles the end of the window.
+    Reader reader = new StringReader(text) {
+      @Override
+      public int read(char[] buffer, int offset, int length) throws IOException {
+        return super.read(buffer, offset, Math.min(1, length));
+      }
+    };
+    Result result = parser.parse(reader, values::add);
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 4, text.length()), result);
+    assertEquals(Arrays.asList(12, 345, 6, 7890), values);
+
+    values.clear();
+    text = "12 34 x";
+    result = parser.parse(Channels.newChannel(new ByteArrayInputStream(text.getBytes(StandardCharsets.UTF_8))),
+        StandardCharsets.UTF_8, values::add);
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 6, "integer"), result);
+    assertEquals(Arrays.asList(12, 34), values);
+  }
+
+  @Test
+  public void testCommit() {
+    Parser parser = LLParser.alternative(
+        LLParser.string("(").commit().then(LLParser.string("a")).skip(LLParser.string(")")),
+        LLParser.string("(").then(LLParser.string("b"))
+    );
+    Parser repetition = LLParser.string("x").commit().then(LLParser.string("y")).many();
+    for (Parser grammar : Arrays.asList(parser, parser.compile(), parser.packrat())) {
+      Result result = grammar.parse("(a)");
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "a", 3), result);
+      result = grammar.parse("(b");
+      assertEquivalentResults(new Result<String>(Status.FAILURE, 1, "a"), result);
+    }
+    for (Parser grammar : Arrays.asList(repetition, repetition.compile())) {
+      Result result = grammar.parse("xyxy");
+      assertEquivalentResults(new Result<List<String>>(Status.SUCCESS, Arrays.asList("y", "y"), 4), result);
+      result = grammar.parse("xyxz");
+      assertEquivalentResults(new Result<String>(Status.FAILURE, 3, "y"), result);
+    }
+  }
+
+  @Test
+  public void testDispatch() {
+    Parser keyword = LLParser.alternative(
+        LLParser.string("select"),
+        LLParser.string("set"),
+        LLParser.regex("\\d+"),
+        LLParser.string("from").commit().then(LLParser.IDENTIFIER),
+        LLParser.character(CharClass.of("\u00e9")),
+        new LLParser<String>((input, index) -> new Result<String>(Status.FAILURE, index, "custom"))
+    );
+    Parser parser = keyword.skip(LLParser.OPTIONAL_WHITESPACES).many();
+    Parser compiled = parser.compile();
+    for (String text : Arrays.asList("select", "set 12 from x", "sex", "from 1", "\u00e9", "\u00e8", "x", "", "12 s")) {
+      assertEquivalentResults(compiled.parse(text), parser.parse(text));
+    }
+
+    Result result = keyword.parse("x");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, Arrays.asList(
+        "select", "set", "regular expression: \\d+", "from", "one of \"\u00e9\"", "custom"
+    )), result);
+    result = keyword.parse("sex");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, Arrays.asList(
+        "select", "set", "regular expression: \\d+", "from", "one of \"\u00e9\"", "custom"
+    )), result);
+
+    // U+01E9 shares the cache slot of U+00E9, so the cached routes evict each other.
+    for (String text : Arrays.asList("\u00e9", "\u01e9", "\u00e9", "\u01e9")) {
+      assertEquivalentResults(parser.parse(text), compiled.parse(text));
+    }
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "\u00e9", 1), keyword.parse("\u00e9"));
+  }
+
+  @Test
+  public void testOneOf() {
+    Parser parser = LLParser.oneOf("<", "<=", "<<=", "=", "select");
+    for (String text : Arrays.asList("<", "<=", "<<=", "=", "select")) {
+      Result result = parser.parse(text);
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, text, text.length()), result);
+      assertSame(text.intern(), result.value);
+    }
+
+    Result result = parser.parse("<<");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 1, "EOF"), result);
+    result = parser.parse("sel");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 0, Arrays.asList("<", "<=", "<<=", "=", "select")), result);
+
+    Map<String, Integer> values = new HashMap<>();
+    values.put("one", 1);
+    values.put("two", 2);
+    values.put("twenty", 20);
+    parser = LLParser.oneOf(values).skip(LLParser.OPTIONAL_WHITESPACES).many();
+    result = parser.parse("twenty two one");
+    assertEquivalentResults(new Result<List<Integer>>(Status.SUCCESS, Arrays.asList(20, 2, 1), 14), result);
+  }
+
+  @Test
+  public void testParallelMany() {
+    Parser parser = LLParser.INTEGER.parallelMany("\n");
+    StringBuilder builder = new StringBuilder();
+    List<Integer> numbers = new ArrayList<>();
+    for (int i = 0; i < 1000; ++ i) {
+      builder.append(i).append('\n');
+      numbers.add(i);
+    }
+    String text = builder.toString();
+    Result result = parser.parse(text);
+    assertEquivalentResults(new Result<List<Integer>>(Status.SUCCESS, numbers, text.length()), result);
+
+    result = parser.parse("");
+    assertEquivalentResults(new Result<List<Integer>>(Status.SUCCESS, Collections.emptyList(), 0), result);
+
+    builder.setLength(0);
+    for (int i = 0; i < 1000; ++ i) {
+      builder.append(i == 500 || i == 800 ? "x" : i).append('\n');
+    }
+    text = builder.toString();
+    result = parser.parse(text);
+    assertEquivalentResults(new Result<String>(Status.FAILURE, text.indexOf('x'), "integer"), result);
+
+    result = LLParser.string("a").then(LLParser.string("b")).parallelMany(";").parse("ab;abb;a");
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 5, "EOF"), result);
+
+    Parser records = LLParser.INTEGER.parallelMany(",");
+    assertThrows(IllegalStateException.class, () -> new Arena().parse(records, "1,2"));
+    assertThrows(IllegalStateException.class, () -> new Profiler().parse(records, "1,2"));
+    assertEquivalentResults(new Result<List<Integer>>(
+        Status.SUCCESS, Arrays.asList(1, 2), 3
+    ), records.packrat().parse("1,2"));
+    IncrementalParser incremental = new IncrementalParser(records);
+    assertEquivalentResults(new Result<List<Integer>>(
+        Status.SUCCESS, Arrays.asList(1, 2), 3
+    ), incremental.parse("1,2"));
+    assertEquivalentResults(new Result<List<Integer>>(
+        Status.SUCCESS, Arrays.asList(1, 23), 4
+    ), incremental.edit(3, 0, "3"));
+  }
+
+  @Test
+  public void testChain() {
+    Parser minus = LLParser.string("-").map(new Function<String, BiFunction<Integer, Integer, Integer>>() {
+      @Override
+      public BiFunction<Integer, Integer, Integer> apply(String value) {
+        return (lhs, rhs) -> lhs - rhs;
+      }
+    });
+    Parser left = LLParser.chainl(LLParser.INTEGER, minus);
+    Parser right = LLParser.chainr(LLParser.INTEGER, minus);
+    String text = "10-3-2";
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 5, text.length()), left.parse(text));
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 9, text.length()), right.parse(text));
+    text = "7";
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 7, text.length()), left.parse(text));
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 7, text.length()), right.parse(text));
+
+    text = "10-";
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 2, "EOF"), left.parse(text));
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 2, "EOF"), right.parse(text));
+    text = "-1";
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 0, "integer"), left.parse(text));
+  }
+
+  @Test
+  public void testExpression() {
+    OperatorTable operators = new OperatorTable()
+        .infix(binary("+"), 1, OperatorTable.Associativity.LEFT)
+        .infix(binary("-"), 1, OperatorTable.Associativity.LEFT)
+        .infix(binary("*"), 2, OperatorTable.Associativity.LEFT)
+        .infix(binary("^"), 3, OperatorTable.Associativity.RIGHT)
+        .prefix(LLParser.string("-").map(new Function<String, Function<Object, String>>() {
+          @Override
+          public Function<Object, String> apply(String value) {
+            return operand -> "-" + operand;
+          }
+        }), 2);
+    Parser parser = LLParser.expression(LLParser.INTEGER, operators);
+    String text = "1+2*3^4^5-6";
+    assertEquivalentResults(new Result<String>(
+        Status.SUCCESS, "((1 + (2 * (3 ^ (4 ^ 5)))) - 6)", text.length()
+    ), parser.parse(text));
+    text = "-2^2*3";
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "-((2 ^ 2) * 3)", text.length()), parser.parse(text));
+    text = "7";
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 7, text.length()), parser.parse(text));
+
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 1, "EOF"), parser.parse("1+"));
+    assertEquivalentResults(new Result<String>(Status.FAILURE, 2, Arrays.asList("-", "integer")), parser.parse("--"));
+  }
+
+  @Test
+  public void testCompiledChain() {
+    OperatorTable operators = new OperatorTable()
+        .infix(binary("+"), 1, OperatorTable.Associativity.LEFT)
+        .infix(binary("-"), 1, OperatorTable.Associativity.LEFT)
+        .infix(binary("*"), 2, OperatorTable.Associativity.LEFT)
+        .infix(binary("^"), 3, OperatorTable.Associativity.RIGHT);
+    Parser[] expression = new Parser[1];
+    Parser operand = LLParser.INTEGER.or(
+        LLParser.string("(").commit().then(LLParser.lazy(() -> expression[0])).skip(LLParser.string(")")));
+    expression[0] = LLParser.expression(operand, operators);
+    Parser left = LLParser.chainl(LLParser.INTEGER, binary("-"));
+    Parser right = LLParser.chainr(LLParser.INTEGER, binary("-"));
+    Parser prefixed = LLParser.expression(operand, operators.prefix(
+        LLParser.string("-").map(value -> (Function<Object, String>) number -> "-" + number), 2));
+    for (Parser parser : Arrays.asList(expression[0], left, right, prefixed)) {
+      Parser compiled = parser.compile();
+      for (String text : Arrays.asList("1+2*3^4^5-6", "(1+2)*3", "10-3-2", "7", "1+", "1-(2", "(", "",
+          "-2^2*3", "--1", "2^-1", "1--2", "-")) {
+        assertEquivalentResults(parser.parse(text), compiled.parse(text));
+      }
+    }
+
+    int depth = 100000;
+    String open = new String(new char[depth]).replace('\0', '(');
+    String text = open + "1+2" + open.replace('(', ')');
+    assertEquivalentResults(new Result<String>(
+        Status.SUCCESS, "(1 + 2)", text.length()
+    ), expression[0].compile().parse(text));
+
+    // Right folds and prefix operators nest through the program's return stack as well.
+    Parser<BiFunction<Integer, Integer, Integer>> minus = LLParser.string("-").map(value -> (lhs, rhs) -> lhs - rhs);
+    text = "1" + new String(new char[depth]).replace("\0", "-1");
+    assertEquivalentResults(new Result<Integer>(
+        Status.SUCCESS, 1, text.length()
+    ), LLParser.chainr(LLParser.INTEGER, minus).compile().parse(text));
+    Parser<Function<Integer, Integer>> negate = LLParser.string("-").map(value -> number -> -number);
+    text = new String(new char[depth]).replace('\0', '-') + "1";
+    assertEquivalentResults(new Result<Integer>(
+        Status.SUCCESS, 1, text.length()
+    ), LLParser.expression(LLParser.INTEGER, new OperatorTable<Integer>().prefix(negate, 1)).compile().parse(text));
+  }
+
+  @Test
+  public void testCompiledSharedSubgraph() {
+    // Every level uses the one below it twice, so inlining shared nodes would need 2^64 instructions.
+    Parser<String> parser = LLParser.string("a");
+    for (int i = 0; i < 64; ++ i) {
+      parser = LLParser.string("b").then(parser).or(parser);
+    }
+    Parser<String> compiled = parser.compile();
+    for (String text : Arrays.asList("a", "bbba", "ba", "b", "c", "")) {
+      assertEquivalentResults(parser.parse(text), compiled.parse(text));
+    }
+  }
+
+  private static Parser binary(String symbol) {
+    return LLParser.string(symbol).map(new Function<String, BiFunction<Object, Object, String>>() {
+      @Override
+      public BiFunction<Object, Object, String> apply(String value) {
+        return (lhs, rhs) -> "(" + lhs + " " + symbol + " " + rhs + ")";
+      }
+    });
+  }
+
+  @Test
+  public void testTypedSequence() {
+    Parser pair = LLParser.sequence(LLParser.IDENTIFIER, LLParser.string("=").then(LLParser.INTEGER),
+        (BiFunction<String, Integer, String>) (key, value) -> key + ":" + value);
+    Parser triple = LLParser.sequence(LLParser.INTEGER, LLParser.string(","), LLParser.INTEGER,
+        (Function3<Integer, String, Integer, Integer>) (lhs, comma, rhs) -> lhs + rhs);
+    Parser quadruple = LLParser.sequence(LLParser.DIGITS, LLParser.DIGITS.skip(LLParser.WHITESPACES).atMost(1),
+        LLParser.string("-"), LLParser.IDENTIFIER,
+        (Function4<String, List<String>, String, String, String>) (a, b, c, d) -> d + c + a + b);
+    String text = "key=42";
+    for (Parser parser : Arrays.asList(pair, pair.compile())) {
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "key:42", text.length()), parser.parse(text));
+      assertEquivalentResults(new Result<String>(Status.FAILURE, 4, "integer"), parser.parse("key="));
+    }
+    text = "1,2";
+    for (Parser parser : Arrays.asList(triple, triple.compile())) {
+      assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 3, text.length()), parser.parse(text));
+      assertEquivalentResults(new Result<Integer>(Status.FAILURE, 1, ","), parser.parse("1"));
+    }
+    text = "12-x";
+    for (Parser parser : Arrays.asList(quadruple, quadruple.compile())) {
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "x-12[]", text.length()), parser.parse(text));
+    }
+  }
+
+  @Test
+  public void testIncrementalParser() {
+    int[] calls = new int[1];
+    Parser word = new LLParser((input, index, context) -> {
+      ++ calls[0];
+      int end = index;
+      while (end < input.length() && Character.isLetter(input.charAt(end))) {
+        ++ end;
+      }
+      return end > index
+          ? Result.success(input.subSequence(index, end).toString(), end)
+          : context.failure(index, "word");
+    });
+    Parser parser = word.skip(LLParser.string("\n")).many();
+    IncrementalParser incremental = new IncrementalParser(parser);
+    Result result = incremental.parse("alpha\nbeta\ngamma\n");
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("alpha", "beta", "gamma"), 17
+    ), result);
+    assertEquals(3, calls[0]);
+
+    calls[0] = 0;
+    result = incremental.edit(6, 4, "delta");
+    assertEquals("alpha\ndelta\ngamma\n", incremental.text());
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("alpha", "delta", "gamma"), 18
+    ), result);
+    assertEquals(1, calls[0]);
+
+    for (int[] edit : new int[][] {{0, 0}, {5, 1}, {18, 0}, {12, 6}}) {
+      String text = incremental.text();
+      String expected = text.substring(0, edit[0]) + "x1" + text.substring(edit[0] + edit[1]);
+      result = incremental.edit(edit[0], edit[1], "x1");
+      assertEquivalentResults(parser.parse(expected), result);
+    }
+
+    // Typing at the end of the document extends the last word.
+    incremental.parse("alpha");
+    result = incremental.edit(5, 0, "x\n");
+    assertEquivalentResults(new Result<List<String>>(Status.SUCCESS, Arrays.asList("alphax"), 7), result);
+    result = incremental.edit(7, 0, "y");
+    assertEquivalentResults(parser.parse("alphax\ny"), result);
+
+    // More edits than the memo table replays, moving the gap back and forth.
+    incremental.parse("alpha\nbeta\ngamma\n");
+    StringBuilder expected = new StringBuilder(incremental.text());
+    for (int i = 0; i < 20; ++ i) {
+      int offset = (i * 7) % (expected.length() + 1);
+      int removed = i % 3 == 0 ? Math.min(2, expected.length() - offset) : 0;
+      String inserted = i % 4 == 0 ? "\n" : "q";
+      expected.replace(offset, offset + removed, inserted);
+      result = incremental.edit(offset, removed, inserted);
+      assertEquals(expected.toString(), incremental.text());
+      assertEquivalentResults(parser.parse(expected.toString()), result);
+    }
+  }
+
+  @Test
+  public void testExpected() {
+    List<String> a = Expected.of("a");
+    List<String> b = Expected.of("b");
+    List<String> c = Expected.of("c");
+    assertEquals(Arrays.asList("a", "b"), Expected.union(a, b));
+    // Duplicates keep their first position.
+    assertEquals(Arrays.asList("a", "b", "c"), Expected.union(Expected.union(a, b), Expected.union(b, c)));
+    assertSame(a, Expected.union(a, Collections.<String>emptyList()));
+    assertSame(a, Expected.union(Collections.<String>emptyList(), a));
+    assertThrows(UnsupportedOperationException.class, () -> Expected.union(a, b).add("d"));
+
+    // Unions only link their operands, the list is built on the first read, without recursion.
+    List<String> expected = Collections.emptyList();
+    for (int i = 0; i < 100000; ++ i) {
+      expected = Expected.union(expected, Expected.of(i % 2 == 0 ? "even" : "odd"));
+    }
+    assertEquals(Arrays.asList("even", "odd"), expected);
+  }
+
+  @Test
+  public void testProfiler() {
+    Parser word = LLParser.IDENTIFIER.named("word");
+    Parser number = LLParser.INTEGER.named("number");
+    Parser value = word.or(number).named("value");
+    Parser parser = value.skip(LLParser.string(" ").atMost(1)).many();
+    Profiler profiler = new Profiler();
+    Result result = profiler.parse(parser, "ab 12 cd");
+    assertEquals(Status.SUCCESS, result.status);
+    assertEquals(8, result.index);
+
+    Map<String, Profiler.Stats> stats = profiler.stats();
+    assertEquals(4, stats.get("value").invocations());
+    assertEquals(3, stats.get("value").successes());
+    assertEquals(6, stats.get("value").consumed());
+    // The dispatch skips word on a digit, both are tried at the end of the input.
+    assertEquals(3, stats.get("word").invocations());
+    assertEquals(2, stats.get("word").successes());
+    assertEquals(2, stats.get("number").invocations());
+    assertEquals(1, stats.get("number").successes());
+    String report = profiler.report();
+    assertTrue(report.contains("value"));
+    assertTrue(report.contains("number"));
+
+    profiler.reset();
+    assertTrue(profiler.stats().isEmpty());
+    assertEquivalentResults(parser.parse("ab 12 cd"), result);
+
+    // A label survives a map over the named rule.
+    Parser upper = LLParser.IDENTIFIER.named("upper").map(String::toUpperCase);
+    result = profiler.parse(upper, "ab");
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "AB", 2), result);
+    assertEquals(1, profiler.stats().get("upper").invocations());
+    assertTrue(profiler.report().contains("upper"));
+
+    // A program is one memo entry, so packrat() runs the interpreted graph and its nodes show up.
+    Parser<String> pair = LLParser.IDENTIFIER.skip(LLParser.string("=")).named("pair");
+    Parser<String> compiled = pair.skip(LLParser.string("1")).or(pair.skip(LLParser.string("2"))).compile();
+    profiler.reset();
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "a", 3), profiler.parse(compiled, "a=2"));
+    assertTrue(!profiler.stats().containsKey("pair"));
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, "a", 3), profiler.parse(compiled.packrat(), "a=2"));
+    assertEquals(2, profiler.stats().get("pair").invocations());
+  }
+
+  @Test
+  public void testIntParser() {
+    Parser<IntBinaryOperator> plus = LLParser.string("+").map(value -> Integer::sum);
+    IntParser sum = LLParser.INTEGER.chainl(plus).mapToInt(value -> -value);
+    ParseContext context = ParseContext.open();
+    try {
+      assertEquals(6, sum.matchInt("1+2+30;", 0, context));
+      assertEquals(-33, context.intValue());
+      assertEquals(~0, sum.matchInt("+1", 0, context));
+      assertEquals(~0, LLParser.INTEGER.matchInt("99999999999", 0, context));
+    } finally {
+      context.close();
+    }
+
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, -33, 6), sum.parse("1+2+30"));
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 1, "EOF"), sum.parse("1+"));
+    assertEquivalentResults(new Result<Integer>(Status.FAILURE, 0, "integer"), sum.parse("+1"));
+    Parser<List<Integer>> sums = sum.skip(LLParser.string(";")).many();
+    assertEquivalentResults(new Result<List<Integer>>(Status.SUCCESS, Arrays.asList(-3, -4), 6), sums.parse("1+2;4;"));
+  }
+
+  @Test
+  public void testManyFold() {
+    Parser<Integer> item = LLParser.INTEGER.skip(LLParser.OPTIONAL_WHITESPACES);
+    Parser<Integer> sum = item.manyFold(0, Integer::sum);
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 10, 8), sum.parse("1 2 3 4 "));
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 0, 0), sum.parse(""));
+    assertEquivalentResults(item.many().parse("1 2 x"), sum.parse("1 2 x"));
+
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 3, 5), item.skipMany().parse("1 2 3"));
+    List<Integer> values = new ArrayList<>();
+    assertEquivalentResults(new Result<Integer>(Status.SUCCESS, 2, 3), item.manyInto(values::add).parse("5 6"));
+    assertEquals(Arrays.asList(5, 6), values);
+
+    Parser<String> repetition = LLParser.string("x").commit().then(LLParser.string("y"));
+    assertEquivalentResults(repetition.many().parse("xyxz"), repetition.skipMany().parse("xyxz"));
+  }
+
+  @Test
+  public void testLexer() {
+    Lexer lexer = new Lexer()
+        .rule("number", LLParser.DIGITS)
+        .rule("let", LLParser.string("let"))
+        .rule("name", LLParser.IDENTIFIER)
+        .rule("=", LLParser.string("="))
+        .ignore(LLParser.WHITESPACES);
+    Parser<String> value = lexer.token("number").or(lexer.token("name"));
+    Parser<String> assignment = LLParser.sequence(
+        lexer.token("let").commit().then(lexer.token("name")), lexer.token("=").then(value),
+        (name, right) -> name + "=" + right);
+    Parser<List<String>> program = assignment.many();
+
+    String text = "let x = 1 let letter=y2 ";
+    TokenStream tokens = lexer.lex(text).value;
+    assertEquals(8, tokens.length());
+    assertEquals("letter", tokens.text(5));
+    assertEquals(20, tokens.start(6));
+    assertEquals(23, tokens.end(7));
+    for (Parser<List<String>> parser : Arrays.asList(program, program.compile())) {
+      assertEquivalentResults(new Result<List<String>>(
+          Status.SUCCESS, Arrays.asList("x=1", "letter=y2"), text.length()
+      ), lexer.parse(parser, text));
+      assertEquivalentResults(new Result<List<String>>(
+          Status.FAILURE, 8, Arrays.asList("number", "name")
+      ), lexer.parse(parser, "let x = = 1"));
+      assertEquivalentResults(new Result<List<String>>(
+          Status.FAILURE, 5, Arrays.asList("=")
+      ), lexer.parse(parser, "let x"));
+    }
+    assertEquals(Status.FAILURE, lexer.lex("let x = #").status);
+    assertEquals(8, lexer.lex("let x = #").index);
+    List<String> expected = new ArrayList<>();
+    for (Parser<?> rule : Arrays.asList(
+        LLParser.DIGITS, LLParser.string("let"), LLParser.IDENTIFIER, LLParser.string("="), LLParser.WHITESPACES)) {
+      expected.addAll(rule.parse("#").expected);
+    }
+    assertEquals(expected, lexer.lex("let x = #").expected);
+
+    // "pair" failed at 1 while lexing the first token, that must not leak into the error at 1.
+    Lexer nested = new Lexer()
+        .rule("pair", LLParser.string("a").then(LLParser.string("bc")))
+        .rule("a", LLParser.string("a"));
+    assertEquivalentResults(new Result<TokenStream>(
+        Status.FAILURE, 1, Arrays.asList("a")
+    ), nested.lex("a#"));
+  }
+
+  @Test
+  public void testParseAll() {
+    Parser<List<String>> parser = LLParser.regex("[a-z]+").memoize().skip(LLParser.string(";")).many();
+    List<String> inputs = Arrays.asList("ab;cd;", "xy;z", "", "x;yz;");
+    List<Result<List<String>>> results = new ArrayList<>();
+    assertEquals(1, parser.parseAll(inputs, results::add));
+    assertEquals(inputs.size(), results.size());
+    for (int i = 0; i < inputs.size(); ++ i) {
+      assertEquivalentResults(parser.parse(inputs.get(i)), results.get(i));
+    }
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("x", "yz"), 5
+    ), results.get(3));
+  }
+
+  @Test
+  public void testRecover() {
+    Parser<String> record = LLParser.sequence(LLParser.IDENTIFIER, LLParser.string("=").then(LLParser.DIGITS),
+        (name, value) -> name + "=" + value).skip(LLParser.string(";"));
+    List<Integer> errors = new ArrayList<>();
+    Parser<List<String>> records = record.recover(LLParser.string(";"), error -> {
+      errors.add(error.index);
+      return null;
+    }).many();
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("a=1", null, "c=3", null), 14
+    ), records.parse("a=1;b=x;c=3;d="));
+    assertEquals(Arrays.asList(6, 14), errors);
+
+    errors.clear();
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("a=1", "b=2"), 8
+    ), records.parse("a=1;b=2;"));
+    assertTrue(errors.isEmpty());
+  }
+
+  @Test
+  public void testLongest() {
+    Parser<String> identifier = LLParser.regex("[a-z][a-z0-9]*");
+    Parser<String> parser = LLParser.longest(
+        LLParser.string("<"), LLParser.string("<="), LLParser.string("if"), identifier);
+    for (Parser<String> p : Arrays.asList(parser, parser.compile())) {
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "<=", 2), p.parse("<="));
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "if", 2), p.parse("if"));
+      assertEquivalentResults(new Result<String>(Status.SUCCESS, "iffy", 4), p.parse("iffy"));
+      assertEquivalentResults(new Result<String>(
+          Status.FAILURE, 0, Arrays.asList("<", "<=", "if", "regular expression: [a-z][a-z0-9]*")
+      ), p.parse("#"));
+    }
+
+    // Exponential for java.util.regex once the 'b' is missing, linear for the DFA.
+    String text = new String(new char[10000]).replace('\0', 'a');
+    Parser<String> ambiguous = LLParser.longest(LLParser.regex("(a|a)*b"));
+    assertEquivalentResults(new Result<String>(Status.SUCCESS, text + "b", text.length() + 1),
+        ambiguous.parse(text + "b"));
+    assertEquivalentResults(new Result<String>(
+        Status.FAILURE, 0, "regular expression: (a|a)*b"
+    ), ambiguous.parse(text));
+
+    Lexer lexer = new Lexer()
+        .rule("number", LLParser.regex("[0-9]+"))
+        .rule("let", LLParser.string("let"))
+        .rule("name", LLParser.regex("[a-z]\\w*"))
+        .rule("=", LLParser.string("="))
+        .ignore(LLParser.regex("\\s+"));
+    Parser<String> assignment = LLParser.sequence(
+        lexer.token("let").then(lexer.token("name")), lexer.token("=").then(lexer.token("number")),
+        (name, value) -> name + "=" + value);
+    text = "let x = 1 let letter=2 ";
+    assertEquivalentResults(new Result<List<String>>(
+        Status.SUCCESS, Arrays.asList("x=1", "letter=2"), text.length()
+    ), lexer.parse(assignment.many(), text));
+    assertEquivalentResults(new Result<TokenStream>(Status.FAILURE, 8, Arrays.asList(
+        "regular expression: [0-9]+", "let", "regular expression: [a-z]\\w*", "=", "regular expression: \\s+"
+    )), lexer.lex("let x = #"));
+  }
 }
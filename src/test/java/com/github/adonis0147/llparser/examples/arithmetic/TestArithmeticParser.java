@@ -1,8 +1,12 @@
 package com.github.adonis0147.llparser.examples.arithmetic;
 
+import com.github.adonis0147.llparser.Arena;
 import org.junit.Test;
 
+import java.util.Arrays;
+
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertThrows;
 
 public class TestArithmeticParser {
 
@@ -24,5 +28,100 @@ public class TestArithmeticParser {
     assertEquals("(0 * ((1 / (2 + 3)) + 4))", parser.parse("0 * ((1 / (2 + 3) + 4))").toString());
     assertEquals("((0 * ((1 / (2 + 3)) + 4)) + 5)", parser.parse("0 * ((1 / (2 + 3) + 4)) + 5").toString());
     assertEquals("(((1 * 2) + ((3 - 4) / 5)) + (((1 - 2) - 3) / 4))", parser.parse("(1*2+(3-4)/5) + \n(1-2-3)/4").toString());
+    assertEquals("(((1 - (2 * 3)) - 4) + ((5 / 6) * 7))", parser.parse("1 - 2 * 3 - 4 + 5 / 6 * 7").toString());
+  }
+
+  @Test
+  public void errorTest() {
+    ArithmeticParser parser = new ArithmeticParser();
+    IllegalArgumentException exception = assertThrows(IllegalArgumentException.class, () -> parser.parse("(1"));
+    assertEquals("Failed to parse the arithmetic expression. columns: 2, expected: [)], content: ((1)",
+        exception.getMessage());
+    exception = assertThrows(IllegalArgumentException.class, () -> parser.parse("1 + "));
+    assertEquals("Failed to parse the arithmetic expression. columns: 2, expected: [EOF], content: (1 + )",
+        exception.getMessage());
+    exception = assertThrows(IllegalArgumentException.class, () -> parser.parse("1 + (2"));
+    assertEquals("Failed to parse the arithmetic expression. columns: 6, expected: [)], content: (... (2)",
+        exception.getMessage());
+  }
+
+  @Test
+  public void deepNestingTest() {
+    ArithmeticParser parser = new ArithmeticParser();
+    int depth = 100000;
+    String open = new String(new char[depth]).replace('\0', '(');
+    String close = new String(new char[depth]).replace('\0', ')');
+    assertEquals("1", parser.parse(open + "1" + close).toString());
+    assertEquals("(1 + 2)", parser.parse(open + "1" + close + " + 2").toString());
+    IllegalArgumentException exception = assertThrows(IllegalArgumentException.class, () -> parser.parse(open + "1"));
+    assertEquals("Failed to parse the arithmetic expression. columns: " + (depth + 1) +
+        ", expected: [)], content: (...((1)", exception.getMessage());
+
+    // The Arena grammars are compiled too, and the tree is evaluated without recursion.
+    String sum = new String(new char[depth]).replace("\0", "(1 + ") + "1" + close;
+    assertEquals(1, parser.evaluate(open + "1" + close));
+    assertEquals(depth + 1, parser.evaluate(sum));
+    Arena arena = new Arena();
+    int root = parser.parse(open + "1" + close, arena);
+    assertEquals(ArithmeticParser.NUMBER, arena.kind(root));
+    assertEquals(1, arena.value(root));
+    root = parser.parse(sum, arena);
+    assertEquals(Operator.ADDITION.ordinal(), arena.kind(root));
+    assertEquals(depth + 1, parser.compile(sum.replace("1 + ", "x + ")).evaluate(1));
+    exception = assertThrows(IllegalArgumentException.class, () -> parser.evaluate(open + "1"));
+    assertEquals("Failed to parse the arithmetic expression. columns: " + (depth + 1) +
+        ", expected: [)], content: (...((1)", exception.getMessage());
+  }
+
+  @Test
+  public void arenaTest() {
+    ArithmeticParser parser = new ArithmeticParser();
+    Arena arena = new Arena();
+    String[] texts = {"1", " ((((1))))\t", "(1 + 2) + 3", "1*(2+3)*4", "(1*2+(3-4)/5) + \n(1-2-3)/4",
+        "1 - 2 * 3 - 4 + 5 / 6 * 7"};
+    for (String text : texts) {
+      arena.reset();
+      int root = parser.parse(text, arena);
+      assertEquals(parser.parse(text).toString(), ArithmeticParser.toString(arena, root));
+    }
+    assertEquals(13, arena.size());
+    IllegalArgumentException exception = assertThrows(IllegalArgumentException.class, () -> parser.parse("1 + (2", arena));
+    assertEquals("Failed to parse the arithmetic expression. columns: 6, expected: [)], content: (... (2)",
+        exception.getMessage());
+  }
+
+  @Test
+  public void evaluateTest() {
+    ArithmeticParser parser = new ArithmeticParser();
+    assertEquals(-9, parser.evaluate("1 - 2 * 3 - 4 + 5 / 6 * 7"));
+    assertEquals(1, parser.evaluate("(1*2+(3-4)/5) + \n(1-2-3)/4"));
+    assertEquals(4611686014132420609L, parser.evaluate("2147483647 * 2147483647"));
+    ArithmeticException exception = assertThrows(ArithmeticException.class,
+        () -> parser.evaluate("2147483647 * 2147483647 * 2147483647"));
+    assertEquals("long overflow", exception.getMessage());
+    exception = assertThrows(ArithmeticException.class, () -> parser.evaluate("1 / (2 - 2)"));
+    assertEquals("Division by zero.", exception.getMessage());
+    // The first operation to throw wins over those after it and those it is part of.
+    exception = assertThrows(ArithmeticException.class,
+        () -> parser.evaluate("(2147483647 * 2147483647 * 2147483647 - 1) * 2 + 1 / 0"));
+    assertEquals("long overflow", exception.getMessage());
+    assertThrows(IllegalArgumentException.class, () -> parser.evaluate("x + 1"));
+
+    Evaluator evaluator = parser.compile("x * (y + 2) - x");
+    assertEquals(Arrays.asList("x", "y"), evaluator.variables());
+    assertEquals(15, evaluator.evaluate(3, 4));
+    assertEquals(-1, evaluator.evaluate(-1, 0));
+    assertEquals(3, parser.compile("1 + 2").evaluate());
+    assertEquals(Arrays.asList("b", "a"), parser.compile("b - a * b").variables());
+    assertEquals(Arrays.asList("x"), parser.compile("x").variables());
+
+    assertEquals(3000000000L, parser.evaluate("3000000000"));
+    assertEquals(Long.MAX_VALUE, parser.evaluate("9223372036854775807"));
+    assertThrows(IllegalArgumentException.class, () -> parser.evaluate("9223372036854775808"));
+    // The syntax error comes first, even though the division by zero is to the left of it.
+    exception = assertThrows(ArithmeticException.class, () -> parser.evaluate("1 / 0"));
+    IllegalArgumentException error = assertThrows(IllegalArgumentException.class, () -> parser.evaluate("1 / 0 +"));
+    assertEquals("Failed to parse the arithmetic expression. columns: 6, expected: [EOF], content: (... 0 +)",
+        error.getMessage());
   }
-}
\ No newline at end of file
+}